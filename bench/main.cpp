@@ -0,0 +1,272 @@
+//Headless benchmark for AutoLOD::genLODMesh, runs a procedural corpus (and any obj files passed in)
+//at a few compression factors and writes the timings of every phase as JSON
+#include "AutoLOD.hpp"
+#include "MeshLoader.hpp"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <vector>
+
+struct BenchMesh{
+    std::string name;
+    std::vector<geo::Facet> facets;
+    std::vector<cgVec3> points;
+};
+
+/**
+ * @brief Deterministic value in [-1,1] for the integer lattice point (i,j)
+ *
+ * @param i
+ * @param j
+ * @return float
+ */
+static float latticeNoise(int i, int j){
+    uint32_t h = uint32_t(i)*374761393u + uint32_t(j)*668265263u;
+    h = (h ^ (h >> 13))*1274126177u;
+    h ^= h >> 16;
+    return float(h & 0xffff)/32767.5f - 1.0f;
+}
+
+/**
+ * @brief Adds the 2 facets of the quad a,b,c,d (counter clockwise)
+ *
+ */
+static void addQuad(std::vector<geo::Facet>& facets, int a, int b, int c, int d){
+    facets.push_back(geo::Facet(a,b,c));
+    facets.push_back(geo::Facet(a,c,d));
+}
+
+/**
+ * @brief Closed uv sphere with one vertex at each pole
+ *
+ * @param res number of rings, there are 2*res segments around
+ * @param mesh
+ */
+static void genSphere(int res, BenchMesh& mesh){
+    mesh.name = "sphere";
+    int nSeg = 2*res;
+    mesh.points.push_back(cgVec3(0,0,1));
+    for(int r = 1; r < res; r++){
+        float theta = float(M_PI)*r/res;
+        for(int s = 0; s < nSeg; s++){
+            float phi = 2.0f*float(M_PI)*s/nSeg;
+            mesh.points.push_back(cgVec3(sinf(theta)*cosf(phi),sinf(theta)*sinf(phi),cosf(theta)));
+        }
+    }
+    mesh.points.push_back(cgVec3(0,0,-1));
+    int south = int(mesh.points.size())-1;
+    auto ring = [nSeg](int r, int s){return 1 + (r-1)*nSeg + (s % nSeg);};
+    for(int s = 0; s < nSeg; s++){
+        mesh.facets.push_back(geo::Facet(0,ring(1,s),ring(1,s+1)));
+        mesh.facets.push_back(geo::Facet(south,ring(res-1,s+1),ring(res-1,s)));
+    }
+    for(int r = 1; r < res-1; r++){
+        for(int s = 0; s < nSeg; s++){
+            addQuad(mesh.facets,ring(r,s),ring(r+1,s),ring(r+1,s+1),ring(r,s+1));
+        }
+    }
+}
+
+/**
+ * @brief Open square heightfield with a couple of waves plus noise, has a horizon all the way around
+ *
+ * @param res number of quads along each side
+ * @param mesh
+ */
+static void genNoisyPlane(int res, BenchMesh& mesh){
+    mesh.name = "noisy_plane";
+    for(int j = 0; j <= res; j++){
+        for(int i = 0; i <= res; i++){
+            float x = float(i)/res;
+            float y = float(j)/res;
+            float z = 0.1f*sinf(6.0f*x)*cosf(4.0f*y) + 0.005f*latticeNoise(i,j);
+            mesh.points.push_back(cgVec3(x,y,z));
+        }
+    }
+    for(int j = 0; j < res; j++){
+        for(int i = 0; i < res; i++){
+            int a = j*(res+1) + i;
+            addQuad(mesh.facets,a,a+1,a+res+2,a+res+1);
+        }
+    }
+}
+
+/**
+ * @brief Closed torus
+ *
+ * @param res number of segments around the tube, there are 2*res around the ring
+ * @param mesh
+ */
+static void genTorus(int res, BenchMesh& mesh){
+    mesh.name = "torus";
+    int nRing = 2*res;
+    for(int i = 0; i < nRing; i++){
+        float u = 2.0f*float(M_PI)*i/nRing;
+        for(int j = 0; j < res; j++){
+            float v = 2.0f*float(M_PI)*j/res;
+            float r = 1.0f + 0.35f*cosf(v);
+            mesh.points.push_back(cgVec3(r*cosf(u),r*sinf(u),0.35f*sinf(v)));
+        }
+    }
+    auto ind = [nRing,res](int i, int j){return (i % nRing)*res + (j % res);};
+    for(int i = 0; i < nRing; i++){
+        for(int j = 0; j < res; j++){
+            addQuad(mesh.facets,ind(i,j),ind(i+1,j),ind(i+1,j+1),ind(i,j+1));
+        }
+    }
+}
+
+/**
+ * @brief Loads every object of an obj file as its own mesh
+ *
+ * @param path
+ * @param meshes
+ */
+static void loadMeshes(const char* path, std::vector<BenchMesh>& meshes){
+    std::vector<objItem*> items;
+    loadOBJFile(path,items,"bench");
+    for(objItem* item : items){
+        BenchMesh mesh;
+        mesh.name = std::string(path) + ":" + item->name;
+        mesh.points = item->positions;
+        for(size_t i = 0; i+2 < item->indices.size(); i += 3){
+            mesh.facets.push_back(geo::Facet(item->indices[i],item->indices[i+1],item->indices[i+2]));
+        }
+        meshes.push_back(mesh);
+        delete item;
+    }
+}
+
+/**
+ * @brief Writes value as a JSON string, mesh names come from file paths and obj object names
+ *
+ * @param out
+ * @param value
+ */
+static void writeString(FILE* out, const std::string& value){
+    fputc('"',out);
+    for(char c : value){
+        if(c == '"' || c == '\\'){
+            fputc('\\',out);
+            fputc(c,out);
+        } else if((unsigned char)c < 0x20){
+            fprintf(out,"\\u%04x",(unsigned char)c);
+        } else {
+            fputc(c,out);
+        }
+    }
+    fputc('"',out);
+}
+
+static void writePhase(FILE* out, const char* name, const AutoLOD::LODPhaseStats& phase){
+    fprintf(out,"\"%s\": {\"seconds\": %.6f, \"peakRSS\": %zu}, ",name,phase.seconds,phase.peakRSS);
+}
+
+static void writeCounters(FILE* out, const AutoLOD::LODCounters& c){
+    fprintf(out,"{\"candidatesEvaluated\": %lld, \"rejectedHorizon\": %lld, \"rejectedNonManifold\": %lld, \"rejectedSharedNeighbors\": %lld, "
+                "\"rejectedNormalFlip\": %lld, \"rejectedZeroArea\": %lld, \"lossFacetCount\": %lld, \"lossZeroArea\": %lld, \"lossNonFinite\": %lld, "
+                "\"collapsesApplied\": %lld, \"skippedAffected\": %lld, \"skippedConflict\": %lld}",
+            (long long)c.candidatesEvaluated,(long long)c.rejectedHorizon,(long long)c.rejectedNonManifold,(long long)c.rejectedSharedNeighbors,
+            (long long)c.rejectedNormalFlip,(long long)c.rejectedZeroArea,(long long)c.lossFacetCount,(long long)c.lossZeroArea,(long long)c.lossNonFinite,
+            (long long)c.collapsesApplied,(long long)c.skippedAffected,(long long)c.skippedConflict);
+}
+
+static void printUsage(){
+    printf("usage: bench [-o results.json] [-res n] [-threads n] [-parallel] [-tiles n] [-qem] [-cluster factor] [file.obj ...]\n");
+}
+
+int main(int argc, char** argv){
+    const char* outPath = "bench.json";
+    int res = 200;
+    AutoLOD::LODOptions options;
+    options.verbose = false; //verbose runs check the graph and print inside the timed phases
+    std::vector<const char*> objPaths;
+    for(int i = 1; i < argc; i++){
+        if(strcmp(argv[i],"-o") == 0 && i+1 < argc){
+            outPath = argv[++i];
+        } else if(strcmp(argv[i],"-res") == 0 && i+1 < argc){
+            res = atoi(argv[++i]);
+        } else if(strcmp(argv[i],"-threads") == 0 && i+1 < argc){
+            options.nThreads = atoi(argv[++i]);
+        } else if(strcmp(argv[i],"-tiles") == 0 && i+1 < argc){
+            options.nTiles = atoi(argv[++i]);
+        } else if(strcmp(argv[i],"-cluster") == 0 && i+1 < argc){
+            options.clusterFactor = float(atof(argv[++i]));
+        } else if(strcmp(argv[i],"-parallel") == 0){
+            options.parallelEcols = true;
+        } else if(strcmp(argv[i],"-qem") == 0){
+            options.costMetric = AutoLOD::LOD_COST_QUADRIC;
+        } else if(argv[i][0] == '-'){
+            printUsage();
+            return 1;
+        } else {
+            objPaths.push_back(argv[i]);
+        }
+    }
+    if(res < 4){
+        res = 4;
+    }
+
+    std::vector<BenchMesh> meshes(3);
+    genSphere(res,meshes[0]);
+    genNoisyPlane(res,meshes[1]);
+    genTorus(res,meshes[2]);
+    for(const char* path : objPaths){
+        loadMeshes(path,meshes);
+    }
+
+    FILE* out = fopen(outPath,"w");
+    if(!out){
+        printf("could not open %s\n",outPath);
+        return 1;
+    }
+    fprintf(out,"{\"threads\": %d, \"parallelEcols\": %s, \"tiles\": %d, \"clusterFactor\": %g, \"costMetric\": \"%s\", \"runs\": [\n",
+            options.nThreads,options.parallelEcols ? "true" : "false",options.nTiles,options.clusterFactor,
+            options.costMetric == AutoLOD::LOD_COST_QUADRIC ? "quadric" : "sin_theta");
+
+    const float compressionFactors[] = {4,20};
+    bool first = true;
+    for(BenchMesh& mesh : meshes){
+        for(float compressionFactor : compressionFactors){
+            AutoLOD::LODStats stats;
+            options.stats = &stats;
+            std::vector<geo::Facet> result;
+            int actualSize = 0;
+            float maxLoss = 0;
+            AutoLOD::genLODMesh(mesh.facets,mesh.points,result,compressionFactor,100.0,actualSize,maxLoss,options);
+
+            fprintf(out,"%s  {\"mesh\": ",first ? "" : ",\n");
+            writeString(out,mesh.name);
+            fprintf(out,", \"compressionFactor\": %g, \"trianglesIn\": %zu, \"trianglesOut\": %zu, \"trianglesPerSecond\": %.1f, "
+                        "\"maxLoss\": %g, \"passes\": %d, \"peakRSSPerPhase\": %s, ",
+                    compressionFactor,mesh.facets.size(),result.size(),
+                    stats.totalSeconds > 0 ? double(mesh.facets.size())/stats.totalSeconds : 0.0,
+                    maxLoss,stats.nPasses,stats.phasePeakRSS ? "true" : "false");
+            writePhase(out,"cluster",stats.cluster);
+            writePhase(out,"tiles",stats.tiles);
+            writePhase(out,"graphBuild",stats.graphBuild);
+            writePhase(out,"horizon",stats.horizon);
+            writePhase(out,"candidateEval",stats.candidateEval);
+            writePhase(out,"collapse",stats.collapse);
+            writePhase(out,"resultCollect",stats.resultCollect);
+            fprintf(out,"\"totalSeconds\": %.6f, \"peakRSS\": %zu, \"counters\": ",stats.totalSeconds,stats.peakRSS);
+            writeCounters(out,stats.counters);
+            fprintf(out,",\n    \"passes\": [");
+            for(size_t i = 0; i < stats.passes.size(); i++){
+                const AutoLOD::LODPassStats& pass = stats.passes[i];
+                fprintf(out,"%s\n      {\"evalSeconds\": %.6f, \"collapseSeconds\": %.6f, \"size\": %d, \"counters\": ",
+                        i == 0 ? "" : ",",pass.evalSeconds,pass.collapseSeconds,pass.size);
+                writeCounters(out,pass.counters);
+                fprintf(out,"}");
+            }
+            fprintf(out,"]}");
+            first = false;
+        }
+    }
+    fprintf(out,"\n]}\n");
+    fclose(out);
+    printf("wrote %s\n",outPath);
+    return 0;
+}
@@ -0,0 +1,296 @@
+//Headless command line front end for AutoLOD, simplifies every object of the obj, ply and stl files it is given
+//(or finds in the directories it is given) and writes the results as obj files
+#include "AutoLOD.hpp"
+#include "MeshLoader.hpp"
+#include "MeshCache.hpp"
+#include "MeshWriter.hpp"
+#include "Parallel.hpp"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+struct CLIOptions{
+    float compressionFactor = 20;
+    int targetTriangles = 0; //if > 0 every object is reduced to at most this many triangles instead
+    float maxSinTheta = 100.0;
+    std::string outDir = "lod";
+    bool useCache = false; //read and write mesh caches next to the inputs
+    AutoLOD::LODOptions lod;
+};
+
+struct CLIJob{
+    fs::path input;
+    fs::path output;
+    uintmax_t bytes = 0;
+
+    //filled in by runJob
+    bool ok = false;
+    std::string error; //why the job failed
+    int nObjects = 0;
+    size_t trianglesIn = 0;
+    size_t trianglesOut = 0;
+    double loadSeconds = 0;
+    double simplifySeconds = 0;
+    double writeSeconds = 0;
+};
+
+static double secondsSince(std::chrono::steady_clock::time_point start){
+    return std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+}
+
+static bool isMeshFile(const fs::path& path){
+    std::string ext = path.extension().string();
+    for(char& c : ext){
+        c = char(tolower(c));
+    }
+    return ext == ".obj" || ext == ".ply" || ext == ".stl";
+}
+
+/**
+ * @brief Name of the obj file written for an input. x.obj and its mesh cache x.obj.amc become x.obj, other
+ * formats keep their extension (x.ply and x.ply.amc become x.ply.obj) so x.ply and x.stl dont write the same file
+ *
+ * @param input
+ * @return fs::path
+ */
+static fs::path outputName(const fs::path& input){
+    fs::path name = input.filename();
+    if(name.extension() == MESH_CACHE_EXTENSION){
+        name = name.stem();
+    }
+    std::string ext = name.extension().string();
+    for(char& c : ext){
+        c = char(tolower(c));
+    }
+    if(ext == ".obj"){
+        return name;
+    }
+    return name += ".obj";
+}
+
+/**
+ * @brief Adds a job for every mesh file (obj, ply or stl) named by input, directories are searched recursively and
+ * their layout is kept below outDir
+ *
+ * @param input
+ * @param outDir
+ * @param jobs
+ * @return false if input doesnt exist
+ */
+static bool collectJobs(const fs::path& input, const fs::path& outDir, std::vector<CLIJob>& jobs){
+    std::error_code ec;
+    if(fs::is_directory(input,ec)){
+        std::vector<fs::path> found;
+        for(const fs::directory_entry& entry : fs::recursive_directory_iterator(input,ec)){
+            if(entry.is_regular_file() && isMeshFile(entry.path())){
+                found.push_back(entry.path());
+            }
+        }
+        std::sort(found.begin(),found.end()); //directory order isnt stable across file systems
+        for(const fs::path& path : found){
+            CLIJob job;
+            job.input = path;
+            job.output = outDir/input.filename()/fs::relative(path,input,ec).parent_path()/outputName(path);
+            job.bytes = fs::file_size(path,ec);
+            jobs.push_back(job);
+        }
+        return true;
+    }
+    if(!fs::is_regular_file(input,ec)){
+        return false;
+    }
+    CLIJob job;
+    job.input = input;
+    job.output = outDir/outputName(input);
+    job.bytes = fs::file_size(input,ec);
+    jobs.push_back(job);
+    return true;
+}
+
+/**
+ * @brief Loads, simplifies and writes one file, a file which cant be loaded or written fails the job (job.error)
+ * and leaves the other jobs running
+ *
+ * @param job
+ * @param options
+ */
+static void runJob(CLIJob& job, const CLIOptions& options){
+    auto start = std::chrono::steady_clock::now();
+    std::vector<objItem*> items;
+    bool loaded = loadMesh(job.input.string(),items,"autolod",options.useCache,options.lod.nThreads,&job.error);
+    job.loadSeconds = secondsSince(start);
+    if(!loaded){
+        job.error = "could not load: " + job.error;
+        return;
+    }
+    job.nObjects = int(items.size());
+
+    start = std::chrono::steady_clock::now();
+    std::vector<std::string> names = std::vector<std::string>(items.size());
+    std::vector<std::vector<geo::Facet>> resultFacets = std::vector<std::vector<geo::Facet>>(items.size());
+    std::vector<std::vector<cgVec3>> resultPoints = std::vector<std::vector<cgVec3>>(items.size());
+    std::vector<std::vector<cgVec3>> resultNormals = std::vector<std::vector<cgVec3>>(items.size());
+    for(size_t m = 0; m < items.size(); m++){
+        objItem* item = items[m];
+        std::vector<geo::Facet> facets = std::vector<geo::Facet>(item->indices.size()/3);
+        for(size_t i = 0; i < facets.size(); i++){
+            facets[i] = geo::Facet(item->indices[i*3+0],item->indices[i*3+1],item->indices[i*3+2]);
+        }
+        std::vector<geo::Facet> simplified;
+        if(options.targetTriangles > 0){
+            std::vector<int> triangleCounts = {options.targetTriangles};
+            std::vector<std::vector<geo::Facet>> levels;
+            std::vector<int> actualSizes;
+            std::vector<float> maxLosses;
+            AutoLOD::genLODChainTriangles(facets,item->positions,triangleCounts,options.maxSinTheta,levels,actualSizes,maxLosses,options.lod);
+            simplified.swap(levels[0]);
+        } else {
+            int actualSize = 0;
+            float maxLoss = 0;
+            AutoLOD::genLODMesh(facets,item->positions,simplified,options.compressionFactor,options.maxSinTheta,actualSize,maxLoss,options.lod);
+        }
+        geo::remapVertices(simplified,item->positions,resultFacets[m],resultPoints[m]);
+        geo::vertexNormals(resultFacets[m],resultPoints[m],resultNormals[m]);
+        names[m] = item->name;
+        job.trianglesIn += facets.size();
+        job.trianglesOut += resultFacets[m].size();
+        delete item;
+    }
+    job.simplifySeconds = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    std::error_code ec;
+    fs::create_directories(job.output.parent_path(),ec);
+    std::vector<OBJWriteItem> objects = std::vector<OBJWriteItem>(names.size());
+    for(size_t m = 0; m < names.size(); m++){
+        objects[m].name = names[m];
+        objects[m].facets = &resultFacets[m];
+        objects[m].points = &resultPoints[m];
+        objects[m].normals = &resultNormals[m];
+    }
+    job.ok = writeOBJFile(job.output.string(),objects,options.lod.nThreads);
+    job.writeSeconds = secondsSince(start);
+    if(!job.ok){
+        job.error = "could not write " + job.output.string();
+        fs::remove(job.output,ec); //dont leave a partial file behind
+    }
+}
+
+static void printUsage(){
+    printf("usage: autolod [-c factor | -t triangles] [-s maxSinTheta] [-o outdir] [-threads n]\n"
+           "               [-parallel] [-tiles n] [-qem] [-cluster factor] [-cache] mesh|dir ...\n"
+           "  mesh      obj, binary ply, binary stl or mesh cache (.amc) file\n"
+           "  -c        keep 1/factor of the vertices of every object (default 20)\n"
+           "  -t        reduce every object to at most this many triangles instead\n"
+           "  -s        maxSinTheta, smaller values preserve sharp edges (default 100)\n"
+           "  -o        output directory, directory inputs keep their layout below it (default lod)\n"
+           "  -threads  total threads, 0 uses every hardware thread (default)\n"
+           "  -cache    load obj files from (and write) a binary mesh cache next to them\n");
+}
+
+int main(int argc, char** argv){
+    CLIOptions options;
+    std::vector<fs::path> inputs;
+    for(int i = 1; i < argc; i++){
+        if(strcmp(argv[i],"-c") == 0 && i+1 < argc){
+            options.compressionFactor = float(atof(argv[++i]));
+        } else if(strcmp(argv[i],"-t") == 0 && i+1 < argc){
+            options.targetTriangles = atoi(argv[++i]);
+        } else if(strcmp(argv[i],"-s") == 0 && i+1 < argc){
+            options.maxSinTheta = float(atof(argv[++i]));
+        } else if(strcmp(argv[i],"-o") == 0 && i+1 < argc){
+            options.outDir = argv[++i];
+        } else if(strcmp(argv[i],"-threads") == 0 && i+1 < argc){
+            options.lod.nThreads = atoi(argv[++i]);
+        } else if(strcmp(argv[i],"-tiles") == 0 && i+1 < argc){
+            options.lod.nTiles = atoi(argv[++i]);
+        } else if(strcmp(argv[i],"-cluster") == 0 && i+1 < argc){
+            options.lod.clusterFactor = float(atof(argv[++i]));
+        } else if(strcmp(argv[i],"-parallel") == 0){
+            options.lod.parallelEcols = true;
+        } else if(strcmp(argv[i],"-cache") == 0){
+            options.useCache = true;
+        } else if(strcmp(argv[i],"-qem") == 0){
+            options.lod.costMetric = AutoLOD::LOD_COST_QUADRIC;
+        } else if(argv[i][0] == '-'){
+            printUsage();
+            return 1;
+        } else {
+            inputs.push_back(argv[i]);
+        }
+    }
+    if(inputs.empty() || (options.targetTriangles <= 0 && options.compressionFactor <= 1)){
+        printUsage();
+        return 1;
+    }
+
+    std::vector<CLIJob> jobs;
+    for(const fs::path& input : inputs){
+        if(!collectJobs(input,options.outDir,jobs)){
+            printf("no such file or directory: %s\n",input.string().c_str());
+            return 1;
+        }
+    }
+    if(jobs.empty()){
+        printf("no mesh files found\n");
+        return 1;
+    }
+    //the jobs run concurrently, two of them writing the same file would leave one result (or a mix of both)
+    std::vector<int> byOutput = std::vector<int>(jobs.size());
+    for(size_t i = 0; i < jobs.size(); i++){
+        byOutput[i] = int(i);
+    }
+    std::sort(byOutput.begin(),byOutput.end(),[&jobs](int a, int b){return jobs[a].output.lexically_normal() < jobs[b].output.lexically_normal();});
+    for(size_t i = 1; i < byOutput.size(); i++){
+        const CLIJob& a = jobs[byOutput[i-1]];
+        const CLIJob& b = jobs[byOutput[i]];
+        if(a.output.lexically_normal() == b.output.lexically_normal()){
+            printf("%s and %s would both be written to %s\n",a.input.string().c_str(),b.input.string().c_str(),a.output.string().c_str());
+            return 1;
+        }
+    }
+
+    //one file per worker, largest first so the run doesnt end waiting on a big file which was started last.
+    //threads left over when there are fewer files than threads go to evaluating the ecols of each mesh
+    std::vector<int> order = std::vector<int>(jobs.size());
+    for(size_t i = 0; i < jobs.size(); i++){
+        order[i] = int(i);
+    }
+    std::stable_sort(order.begin(),order.end(),[&jobs](int a, int b){return jobs[a].bytes > jobs[b].bytes;});
+    int nThreads = par::numThreads(options.lod.nThreads);
+    int nWorkers = std::min(nThreads,int(jobs.size()));
+    options.lod.nThreads = std::max(1,nThreads/nWorkers);
+    options.lod.verbose = false;
+
+    std::mutex printLock;
+    auto start = std::chrono::steady_clock::now();
+    par::parallelFor(int(jobs.size()),nWorkers,[&](int i, int thread){
+        CLIJob& job = jobs[order[i]];
+        runJob(job,options);
+        std::lock_guard<std::mutex> lock(printLock);
+        if(job.ok){
+            printf("%s: %d objects, %zu -> %zu triangles, load %.3fs, simplify %.3fs, write %.3fs\n",
+                   job.input.string().c_str(),job.nObjects,job.trianglesIn,job.trianglesOut,
+                   job.loadSeconds,job.simplifySeconds,job.writeSeconds);
+        } else {
+            printf("%s: failed, %s\n",job.input.string().c_str(),job.error.c_str());
+        }
+        fflush(stdout);
+    },1);
+
+    int nFailed = 0;
+    for(const CLIJob& job : jobs){
+        nFailed += job.ok ? 0 : 1;
+    }
+    printf("%zu files in %.3fs with %d workers, %d failed\n",jobs.size(),secondsSince(start),nWorkers,nFailed);
+    return nFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,98 @@
+//Memory arena used by AutoLODGraph so its containers dont go through malloc/free one allocation at a time
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <cstddef>
+#include <vector>
+#include <new>
+#include <type_traits>
+
+/**
+ * @brief Bump allocator which hands out memory from large blocks and frees all of it at once
+ * when it is destroyed. Freed allocations go on a free list for their power of two size class
+ * and are reused by later allocations of that class, allocations bigger than half a block get
+ * a block of their own. Not thread safe.
+ *
+ */
+class Arena{
+    public:
+    Arena(size_t blockSize = 1 << 20);
+    ~Arena();
+    Arena(const Arena&) = delete;
+    Arena& operator = (const Arena&) = delete;
+
+    void* allocate(size_t bytes);
+    void deallocate(void* p, size_t bytes);
+
+    /**
+     * @brief Frees every block, all memory handed out by the arena becomes invalid
+     *
+     */
+    void release();
+
+    size_t bytesReserved(){return reserved;} //bytes currently held from the system
+
+    private:
+    struct FreeBlock{
+        FreeBlock* next;
+    };
+    static const int nClasses = 48;
+    static const size_t minClassSize = 16;
+
+    static int sizeClass(size_t bytes);
+
+    std::vector<char*> blocks;
+    std::vector<void*> largeBlocks;
+    char* cur = nullptr;
+    char* end = nullptr;
+    size_t blockSize;
+    size_t reserved = 0;
+    FreeBlock* freeLists[nClasses] = {};
+};
+
+/**
+ * @brief Allocator policy for the containers of the simplifier. Allocates from arena,
+ * or from the heap when arena is nullptr, so the same container types work either way.
+ *
+ * @tparam T
+ */
+template <class T>
+struct ArenaAllocator{
+    typedef T value_type;
+    //containers keep the arena they were built with when they are moved or assigned
+    typedef std::true_type propagate_on_container_copy_assignment;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    Arena* arena = nullptr;
+
+    ArenaAllocator(){}
+    ArenaAllocator(Arena* arena){this->arena = arena;}
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U>& a){arena = a.arena;}
+
+    T* allocate(size_t n){
+        if(arena){
+            return (T*)arena->allocate(n*sizeof(T));
+        }
+        return (T*)::operator new(n*sizeof(T));
+    }
+
+    void deallocate(T* p, size_t n){
+        if(arena){
+            arena->deallocate(p,n*sizeof(T));
+        } else {
+            ::operator delete(p);
+        }
+    }
+
+    template <class U>
+    bool operator == (const ArenaAllocator<U>& a) const {return arena == a.arena;}
+    template <class U>
+    bool operator != (const ArenaAllocator<U>& a) const {return arena != a.arena;}
+};
+
+template <class T>
+using ArenaVector = std::vector<T,ArenaAllocator<T>>;
+
+#endif /* ARENA_HPP */
@@ -2,35 +2,219 @@
 #define AUTOLOD_HPP
 
 #include "Geometry.hpp"
-#include <unordered_set>
+#include "Arena.hpp"
+#include <memory>
+#include <algorithm>
+#include <functional>
+#include <cstdint>
+#include <chrono>
+#include <atomic>
+#include <limits>
 
 namespace AutoLOD{
 
-    struct AutoLODGraphNode{
+    /**
+     * @brief Cost used to order the ecol operations
+     * 
+     */
+    enum LODCostMetric{
+        LOD_COST_MAX_SIN_THETA, //change in facet normals and aspect ratio over the one-rings, weighted by maxSinTheta
+        LOD_COST_QUADRIC //squared distance from the kept vertex to the planes of the original facets it has absorbed
+    };
 
-        AutoLODGraphNode(int vertInd){
-            this->vertInd = vertInd;
+    /**
+     * @brief A candidate half edge collapse of v_remove into v_keep.
+     * stamp is the stamp of v_remove when the loss was evaluated, the
+     * candidate is stale once the vertex's stamp moves on.
+     * 
+     */
+    struct EcolCandidate{
+        float loss;
+        int v_keep;
+        int v_remove;
+        int stamp;
+        EcolCandidate(float loss, int v_keep, int v_remove, int stamp){
+            this->loss=loss; this->v_keep=v_keep; this->v_remove=v_remove; this->stamp=stamp;
         }
+        //ordered by loss, ties broken by vertex indices
+        bool operator > (const EcolCandidate& c) const {
+            return std::make_tuple(loss,v_keep,v_remove) > std::make_tuple(c.loss,c.v_keep,c.v_remove);
+        }
+    };
+
+    /**
+     * @brief Persistent min heap of candidate edge collapses which lives across passes.
+     * Entries are never removed when they go out of date, they are skipped when popped
+     * (or dropped by compact) once their stamp no longer matches the remove node.
+     * 
+     */
+    class EcolQueue{
+        public:
+        void push(const EcolCandidate& c){
+            heap.push_back(c);
+            std::push_heap(heap.begin(),heap.end(),std::greater<EcolCandidate>());
+        }
+
+        EcolCandidate pop(){
+            std::pop_heap(heap.begin(),heap.end(),std::greater<EcolCandidate>());
+            EcolCandidate c = heap.back();
+            heap.pop_back();
+            return c;
+        }
+
+        bool empty(){return heap.empty();}
+
+        int size(){return int(heap.size());} //includes stale entries
 
-        int vertInd; //index of the vertex that this node represents
-        std::unordered_set<int> adjacentNodes; //adjacent nodes
-        std::unordered_set<geo::Facet, geo::Facet::HashFunctionUnordered> facets; //facets touching this node
-        bool wasAffected = false; //this gets set to true indicating when this is involved in an ecol indicating that its loss value is out of date
-        
         /**
-         * @brief metric describing how much topological information is contained in this vertex
-         * basically increases when facets arent parallel, and increases for larger facets.
+         * @brief Drop every entry for which isStale returns true and rebuild the heap
          * 
-         * @return float 
+         * @param isStale 
          */
-        float getLoss(std::vector<cgVec3>& points);
+        template <class F>
+        void compact(F isStale){
+            heap.erase(std::remove_if(heap.begin(),heap.end(),isStale),heap.end());
+            std::make_heap(heap.begin(),heap.end(),std::greater<EcolCandidate>());
+        }
+
+        int nLive = 0; //number of entries that are not stale, maintained by AutoLODGraph::queueEcols
 
+        private:
+        std::vector<EcolCandidate> heap;
     };
 
+    /**
+     * @brief Result of AutoLODGraph::checkEcol
+     * 
+     */
+    enum EcolCheck{
+        ECOL_LEGAL,
+        ECOL_HORIZON, //the removed vertex is on the horizon
+        ECOL_NON_MANIFOLD, //the edge has more than 2 facets (non-manifold input), it is left in place
+        ECOL_SHARED_NEIGHBORS, //the vertices dont share exactly 2 neighbors, the collapse would make the mesh non-manifold
+        ECOL_NORMAL_FLIP, //a reshaped facet would flip
+        ECOL_ZERO_AREA //a reshaped facet would have zero area
+    };
+
+    /**
+     * @brief Counts of what happened to the ecol candidates, filled in when LODOptions::stats is set
+     * 
+     */
+    struct LODCounters{
+        int64_t candidatesEvaluated = 0; //ecols checked with checkEcol, including the ones ruled out by the horizon
+        int64_t rejectedHorizon = 0;
+        int64_t rejectedNonManifold = 0;
+        int64_t rejectedSharedNeighbors = 0;
+        int64_t rejectedNormalFlip = 0;
+        int64_t rejectedZeroArea = 0;
+        int64_t lossFacetCount = 0; //getEcolLoss returned -1, the edge doesnt have 2 facets
+        //getEcolLoss returned -2: a facet around the kept vertex already has zero area (degenerate input).
+        //reshaped facets with zero area are rejected before by checkEcol, as rejectedZeroArea
+        int64_t lossZeroArea = 0;
+        int64_t lossNonFinite = 0; //the loss was nan or inf (degenerate facets), never queued
+        int64_t collapsesApplied = 0;
+        int64_t skippedAffected = 0; //popped ecols dropped because a vertex was flagged wasAffected
+        int64_t skippedConflict = 0; //popped ecols deferred because their region overlapped a picked one (parallelEcols)
+
+        void add(const LODCounters& c);
+    };
+
+    /**
+     * @brief Ordered record of the edge collapses applied to a mesh, stored in flat arrays.
+     * Collapse i removed vertex remove[i] and facets removedFacets[2i] and removedFacets[2i+1], and
+     * replaced remove[i] by keep[i] in rewrittenFacets[rewrittenBegin[i]] to rewrittenFacets[rewrittenBegin[i+1]-1].
+     * Vertex and facet indices refer to the mesh passed to genLODMesh.
+     * 
+     */
+    struct CollapseLog{
+        std::vector<int> keep;
+        std::vector<int> remove;
+        std::vector<int> removedFacets;
+        std::vector<int> rewrittenBegin = {0};
+        std::vector<int> rewrittenFacets;
+
+        int size() const {return int(keep.size());}
+
+        /**
+         * @brief Appends collapse i of log, mapping its indices through vertexMap and facetMap
+         * (an empty map leaves the indices as they are)
+         * 
+         * @param log 
+         * @param i 
+         * @param vertexMap 
+         * @param facetMap 
+         */
+        void append(const CollapseLog& log, int i, const std::vector<int>& vertexMap, const std::vector<int>& facetMap);
+
+        /**
+         * @brief Appends every collapse of log, mapping its indices through vertexMap and facetMap
+         * 
+         * @param log 
+         * @param vertexMap 
+         * @param facetMap 
+         */
+        void append(const CollapseLog& log, const std::vector<int>& vertexMap, const std::vector<int>& facetMap);
+    };
+
+    /**
+     * @brief Mesh connectivity used for edge collapses, stored in flat arrays.
+     * Facets keep the index they had in the input mesh, and every facet has 3 corners
+     * (corner c belongs to facet c/3 and sits at facets[c/3].inds[c%3]).
+     * The corners touching a vertex are chained into a singly linked list starting at
+     * vertCorner[v] and continuing through cornerNext, which gives the one-ring of
+     * the vertex without any per vertex allocations.
+     * The containers allocate from an arena owned by the graph, which is freed in one go with the graph.
+     * 
+     */
     class AutoLODGraph{
 
         public:
-        AutoLODGraph(std::vector<geo::Facet>& facets, std::vector<cgVec3>& points);
+        /**
+         * @brief Builds the graph from a mesh
+         * 
+         * @param facets 
+         * @param points 
+         * @param useArena allocate the containers from the graph's arena instead of the heap
+         */
+        AutoLODGraph(std::vector<geo::Facet>& facets, std::vector<cgVec3>& points, bool useArena = true);
+
+        /**
+         * @brief metric describing how much topological information is contained in a vertex
+         * basically increases when facets arent parallel, and increases for larger facets.
+         * Uses the cached facet geometry, which is computed from ptsCopy.
+         * 
+         * @param points 
+         * @param v 
+         * @return float 
+         */
+        float getLoss(std::vector<cgVec3>& points, int v);
+
+        /**
+         * @brief Recomputes the cached normal, area and aspect ratio of facet f from ptsCopy
+         * 
+         * @param f 
+         */
+        void updateFacetGeometry(int f);
+
+        cgVec3 getFacetNormal(int f){return cgVec3(facetNormalX[f],facetNormalY[f],facetNormalZ[f]);}
+
+        /**
+         * @brief Appends the unique vertices sharing an edge with v to target
+         * 
+         * @param v 
+         * @param target 
+         */
+        void getNeighbors(int v, std::vector<int>& target);
+
+        /**
+         * @brief Appends the facets containing both v0 and v1 to target, returns how many there were
+         * 
+         * @param v0 
+         * @param v1 
+         * @param target 
+         * @return int 
+         */
+        int getEdgeFacets(int v0, int v1, std::vector<int>& target);
 
         /**
          * @brief Half edge collapse - remove edge between v_keep and v_remove by removing v_remove
@@ -41,18 +225,59 @@ namespace AutoLOD{
         void ecol(int v_keep, int v_remove);
 
         /**
-         * @brief How much loss would be generated by edge collapsing neighborNode into this node
+         * @brief Half edge collapse which appends the nodes it flags wasAffected to affected
+         * instead of affectedNodes, and records itself in log instead of collapseLog.
+         * ecols whose regions (v_keep, v_remove and their neighbors) dont overlap touch
+         * disjoint parts of the graph, so they can run on separate threads.
+         * 
+         * @param v_keep 
+         * @param v_remove 
+         * @param affected 
+         * @param log can be nullptr
+         */
+        void ecol(int v_keep, int v_remove, std::vector<int>& affected, CollapseLog* log);
+
+        /**
+         * @brief How much loss would be generated by edge collapsing neighborNode into this node.
+         * The reshaped facets are evaluated together with geo::triMetricsBatch on the ptsX/ptsY/ptsZ streams.
          * 
          * @param points 
-         * @param neighborNode neighboring node - must exist in adjacentNodes
+         * @param neighborNode neighboring node - must share an edge with thisnode
          * @return float 
          */
         float getEcolLoss(std::vector<cgVec3>& points, int thisnode, int neighborNode, float maxSinTheta);
 
+        /**
+         * @brief Sets every vertex quadric to the sum of the quadrics of the facets touching it,
+         * from then on ecol adds the quadric of the removed vertex into the kept one
+         * 
+         */
+        void computeQuadrics();
+
+        /**
+         * @brief Quadric error of collapsing v_remove into v_keep, computeQuadrics must have been called
+         * 
+         * @param v_keep 
+         * @param v_remove 
+         * @return float 
+         */
+        float getQuadricLoss(int v_keep, int v_remove);
+
+        /**
+         * @brief Same checks as ecolIsLegal, returning which one failed
+         * 
+         * @param v_keep 
+         * @param v_remove 
+         * @return EcolCheck 
+         */
+        EcolCheck checkEcol(int v_keep, int v_remove);
+
         /**
          * @brief Checks to see if edge collapse is legal: 
+         *        - the edge has exactly 2 facets, edges of non-manifold input are left in place
          *        - doesnt produce a non-manifold mesh (duplicates faces)
          *        - doest flip faces
+         *        - doesnt produce zero area faces
          * 
          * @param v_keep 
          * @param v_remove 
@@ -61,25 +286,250 @@ namespace AutoLOD{
          */
         bool ecolIsLegal(int v_keep, int v_remove);
 
-        ~AutoLODGraph();
+        /**
+         * @brief Evaluates every legal ecol which removes v_remove and appends it to target.
+         * Only reads the graph so it is safe to call from several threads at once.
+         * 
+         * @param v_remove 
+         * @param maxSinTheta 
+         * @param metric 
+         * @param target 
+         * @param counters if not nullptr, the candidates and rejections are added to it
+         */
+        void getEcols(int v_remove, float maxSinTheta, LODCostMetric metric, std::vector<EcolCandidate>& target,
+                      LODCounters* counters = nullptr);
+
+        /**
+         * @brief Re-evaluates every legal ecol which removes one of the vertices and pushes it into queue,
+         * any previously queued ecols removing those vertices are invalidated first.
+         * The evaluation is split across nThreads threads.
+         * 
+         * @param vertices 
+         * @param maxSinTheta 
+         * @param metric 
+         * @param queue 
+         * @param nThreads 
+         * @param counters if not nullptr, the candidates and rejections are added to it
+         */
+        void queueEcols(std::vector<int>& vertices, float maxSinTheta, LODCostMetric metric, EcolQueue& queue, int nThreads,
+                        LODCounters* counters = nullptr);
+
+        /**
+         * @brief Returns true if the candidate was evaluated before its remove node last changed
+         * 
+         * @param c 
+         * @return true 
+         * @return false 
+         */
+        bool isStale(const EcolCandidate& c);
 
         void print(){
             std::cout << "AutoLODGraph Info:"<<"\n";
-            std::cout << "nNodes = "<<nodes->calcSize()<<"\n";
+            std::cout << "nNodes = "<<calcSize()<<"\n";
         }
 
+        int calcSize(); //counts the alive vertices, dont do this every loop iteration if you care about performance...
+
         /**
          * @brief Checks every single graph node to make sure it is in a legal configuration
-         * checks that adjacency is shared between nodes.
-         * checks that every facet index exists as a node.
+         * checks that every corner in a vertex list belongs to a live facet at that vertex.
+         * checks that every live facet is in the lists of its 3 vertices, which must be alive.
          * 
          */
         void debugCheckGraphLegality();
 
-        HashTable128* nodes;
+        std::unique_ptr<Arena> arena; //declared first so it outlives the containers using it, nullptr when the heap is used
+
+        ArenaVector<geo::Facet> facets; //indexed by facet id, dead facets keep their last indices
+        ArenaVector<uint8_t> facetAlive;
+        ArenaVector<int> cornerNext; //next corner around the same vertex, -1 at the end of the list
+        ArenaVector<int> vertCorner; //first corner of each vertex, -1 if the vertex has no facets
+        ArenaVector<uint8_t> vertAlive; //vertex is referenced by the mesh and hasnt been removed by ecol
+        ArenaVector<uint8_t> wasAffected; //set by ecol when a vertex one-ring changes, indicating that its loss value is out of date
+        ArenaVector<int> stamp; //incremented whenever the queued ecols removing a vertex go out of date
+        ArenaVector<int> nCandidates; //number of live queued ecols that remove a vertex
+        ArenaVector<geo::Quadric> quadrics; //per vertex error quadrics, empty unless computeQuadrics was called
+
+        //per facet geometry, only changes when ecol rewrites a facet so it is cached instead of recomputed for every candidate
+        ArenaVector<float> facetNormalX;
+        ArenaVector<float> facetNormalY;
+        ArenaVector<float> facetNormalZ;
+        ArenaVector<float> facetArea;
+        ArenaVector<float> facetAspectRatio;
+
         std::vector<cgVec3> ptsCopy;
-        std::unordered_set<geo::Edge, geo::Edge::HashFunction> horizonEdges;
-        std::unordered_set<int> horizonVerts;
+        ArenaVector<float> ptsX; //ptsCopy split into coordinate streams for the batch triangle kernels
+        ArenaVector<float> ptsY;
+        ArenaVector<float> ptsZ;
+        ArenaVector<uint8_t> horizonVert; //vertex is on a horizon edge (an edge with only one facet), these are never removed
+        std::vector<int> affectedNodes; //nodes flagged wasAffected by ecol since the list was last cleared
+        CollapseLog* collapseLog = nullptr; //if set, ecol records every collapse in it
+        double horizonSeconds = 0; //time the constructor spent finding the horizon edges
+    };
+
+    /**
+     * @brief Replays a CollapseLog over the mesh it was recorded on, moving to any number of
+     * applied collapses by applying or undoing only the collapses in between.
+     * 
+     */
+    class ProgressiveMesh{
+
+        public:
+        /**
+         * @brief Starts at the full mesh (no collapses applied)
+         * 
+         * @param baseFacets the facets the log was recorded on
+         * @param log 
+         */
+        ProgressiveMesh(std::vector<geo::Facet>& baseFacets, CollapseLog& log);
+
+        /**
+         * @brief Applies or undoes collapses until exactly nCollapses of them are applied
+         * 
+         * @param nCollapses clamped to [0,log.size()]
+         */
+        void setCollapseCount(int nCollapses);
+
+        /**
+         * @brief Moves to the finest state with at most nTriangles facets (every collapse removes 2)
+         * 
+         * @param nTriangles 
+         */
+        void setTriangleCount(int nTriangles);
+
+        void collapse(); //apply the next collapse
+        void split(); //undo the last applied collapse
+
+        int getCollapseCount(){return nApplied;}
+        int getTriangleCount(){return nAliveFacets;}
+
+        /**
+         * @brief Appends the current facets to target
+         * 
+         * @param target 
+         */
+        void getFacets(std::vector<geo::Facet>& target);
+
+        std::vector<geo::Facet> facets; //indexed like the base mesh
+        std::vector<uint8_t> facetAlive;
+        CollapseLog log;
+
+        private:
+        int nApplied = 0;
+        int nAliveFacets = 0;
+    };
+
+    /**
+     * @brief Time spent in one phase of genLODMesh and the peak resident set size of the process during the phase.
+     * See LODStats::phasePeakRSS for where the peak is cumulative instead.
+     * 
+     */
+    struct LODPhaseStats{
+        double seconds = 0;
+        size_t peakRSS = 0; //bytes
+    };
+
+    /**
+     * @brief One ecol pass of genLODMesh
+     * 
+     */
+    struct LODPassStats{
+        double evalSeconds = 0; //evaluating and queueing ecols
+        double collapseSeconds = 0; //picking and applying ecols
+        int size = 0; //vertices left after the pass
+        LODCounters counters;
+    };
+
+    /**
+     * @brief Timings and counters filled in by genLODMesh when LODOptions::stats is set
+     * 
+     */
+    struct LODStats{
+        LODPhaseStats cluster; //grid vertex clustering, only when clusterFactor is set
+        LODPhaseStats tiles; //simplifying the cells on their own, only when nTiles > 1
+        LODPhaseStats graphBuild; //building the graph, not counting the horizon detection
+        LODPhaseStats horizon; //finding the horizon edges, happens inside graphBuild and has its peak RSS
+        LODPhaseStats candidateEval; //evaluating and queueing ecols
+        LODPhaseStats collapse; //picking and applying ecols
+        LODPhaseStats resultCollect; //copying out the resulting facets
+        double totalSeconds = 0;
+        size_t peakRSS = 0; //bytes, the peak during the run when phasePeakRSS is set, otherwise the peak of the process so far
+        //true where the peak RSS can be reset (linux), every phase then has its own peak. Otherwise each phase has the
+        //peak of the process when it ended, which includes every earlier phase. The peak is process wide either way,
+        //so meshes simplified at the same time (genLODMeshes) show up in each others peaks
+        bool phasePeakRSS = false;
+        int nPasses = 0;
+        std::vector<LODPassStats> passes; //passes over the whole graph, the tile passes are only in the tiles phase
+        LODCounters counters; //sum over passes
+    };
+
+    /**
+     * @brief Peak resident set size of the process in bytes since the last resetPeakRSS, 0 where it cant be measured
+     * 
+     * @return size_t 
+     */
+    size_t peakRSS();
+
+    /**
+     * @brief Resets the peak resident set size of the process to the current one (linux only)
+     * 
+     * @return false if it cant be reset here, peakRSS then keeps the peak since the process started
+     */
+    bool resetPeakRSS();
+
+    /**
+     * @brief Why genLODMesh stopped collapsing
+     * 
+     */
+    enum LODStopReason{
+        LOD_STOP_TARGET_REACHED,
+        LOD_STOP_NO_LEGAL_ECOLS, //ran out of legal ecols before the target
+        LOD_STOP_MAX_LOSS, //every remaining ecol costs more than LODOptions::maxLoss
+        LOD_STOP_DEADLINE, //LODOptions::deadline passed
+        LOD_STOP_CANCELLED //LODOptions::cancel was set
+    };
+
+    /**
+     * @brief Optional settings for genLODMesh
+     * 
+     */
+    struct LODOptions{
+        int nThreads = 0; //threads used to evaluate ecols, 0 uses one per hardware thread
+        bool parallelEcols = false; //apply each pass as a set of non overlapping ecols spread across the threads
+        LODCostMetric costMetric = LOD_COST_MAX_SIN_THETA;
+        int nTiles = 1; //number of spatial cells (k-d split of the points) simplified on their own threads before a final pass across the seams
+        CollapseLog* collapseLog = nullptr; //if set, receives every ecol in the order it was applied (replay it with ProgressiveMesh)
+        bool useArena = true; //graph containers are allocated from one arena per graph and freed all at once
+        LODStats* stats = nullptr; //if set, receives the time spent in each phase
+        //ecols costing more than this (in the units of costMetric) are never applied, the collapses stop
+        //once the cheapest remaining one is above it even if the target size wasnt reached
+        float maxLoss = std::numeric_limits<float>::infinity();
+        //if > 0 and the mesh has more than clusterFactor times the vertices of the finest level, grid vertex clustering
+        //(clusterVertices) brings it down to about that many before the ecols start. Skipped when collapseLog is set
+        float clusterFactor = 0;
+        //the deadline and cancel flag are checked before and after each pass evaluates its ecols, when either
+        //trips the mesh reached so far is returned (levels which werent reached get that mesh as well)
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+        std::atomic<bool>* cancel = nullptr; //if set, can be set from another thread to stop early
+        std::function<void(int,int)> progress; //if set, called between passes with (vertices left, vertex count of the coarsest level)
+        bool verbose = true; //print the mesh sizes and run the graph debug check, off for batches
+    };
+
+    /**
+     * @brief One mesh of a genLODMeshes batch, the results are filled in by genLODMeshes
+     * 
+     */
+    struct LODBatchItem{
+        std::vector<geo::Facet>* facets = nullptr;
+        std::vector<cgVec3>* points = nullptr;
+        float compressionFactor = 20;
+        LODStats* stats = nullptr; //used instead of LODOptions::stats for this mesh
+        CollapseLog* collapseLog = nullptr; //used instead of LODOptions::collapseLog for this mesh
+
+        std::vector<geo::Facet> result;
+        int actualSize = 0;
+        float achievedMaxLoss = 0;
+        LODStopReason stopReason = LOD_STOP_TARGET_REACHED;
     };
 
     /**
@@ -97,6 +547,80 @@ namespace AutoLOD{
                  std::vector<cgVec3>& meshPoints,
                  std::vector<geo::Facet>& targetFacets,
                  float compressionFactor,float maxSinTheta, int& actualSize );
+
+    /**
+     * @brief Generate a coarser mesh with 1/compressionFactor vertices from basemesh
+     * 
+     * @param meshFacets base mesh facets
+     * @param meshPoints base mesh points
+     * @param targetFacets resulting facets
+     * @param compressionFactor 0 to collapse until options.maxLoss is reached
+     * @param maxSinTheta a smaller value makes the algorithm try to preserve sharp edges over 
+     * keeping the triangle aspect ratio close to 1.
+     * @param actualSize actual number of vetices in resulting mesh
+     * @param achievedMaxLoss highest loss of the ecols which were applied
+     * @param options 
+     * @return LODStopReason 
+     */
+    LODStopReason genLODMesh(std::vector<geo::Facet>& meshFacets, 
+                 std::vector<cgVec3>& meshPoints,
+                 std::vector<geo::Facet>& targetFacets,
+                 float compressionFactor,float maxSinTheta, int& actualSize, float& achievedMaxLoss,
+                 const LODOptions& options );
+
+    /**
+     * @brief Runs genLODMesh on every item, spread over a pool of options.nThreads workers which
+     * take the meshes largest first, so the wall time follows the largest mesh rather than the sum.
+     * With fewer meshes than threads the spare threads are split between the meshes.
+     * The meshes run quietly, and options.stats, options.collapseLog and options.progress are
+     * replaced by the stats and log of each item (and no progress).
+     * 
+     * @param items 
+     * @param maxSinTheta 
+     * @param options 
+     */
+    void genLODMeshes(std::vector<LODBatchItem>& items, float maxSinTheta, const LODOptions& options = LODOptions());
+
+    /**
+     * @brief Generate a chain of coarser meshes in one run, each level is taken as the collapses
+     * pass its size so the cost is about that of generating the coarsest level on its own.
+     * Unlike genLODMesh the passes stop exactly at each level (also with a single level), unless the
+     * collapses run out first.
+     * 
+     * @param meshFacets base mesh facets
+     * @param meshPoints base mesh points
+     * @param compressionFactors one per level, in any order
+     * @param maxSinTheta 
+     * @param targetLevels receives the facets of each level, in the order of compressionFactors
+     * @param actualSizes actual number of vertices in each level
+     * @param achievedMaxLosses highest loss of the ecols applied to reach each level
+     * @param options 
+     * @return LODStopReason 
+     */
+    LODStopReason genLODChain(std::vector<geo::Facet>& meshFacets, 
+                 std::vector<cgVec3>& meshPoints,
+                 std::vector<float>& compressionFactors, float maxSinTheta,
+                 std::vector<std::vector<geo::Facet>>& targetLevels, std::vector<int>& actualSizes,
+                 std::vector<float>& achievedMaxLosses, const LODOptions& options = LODOptions() );
+
+    /**
+     * @brief Same as genLODChain with the levels given as maximum triangle counts
+     * 
+     * @param meshFacets base mesh facets
+     * @param meshPoints base mesh points
+     * @param triangleCounts one per level, in any order
+     * @param maxSinTheta 
+     * @param targetLevels receives the facets of each level, in the order of triangleCounts
+     * @param actualSizes actual number of vertices in each level
+     * @param achievedMaxLosses highest loss of the ecols applied to reach each level
+     * @param options 
+     * @return LODStopReason 
+     */
+    LODStopReason genLODChainTriangles(std::vector<geo::Facet>& meshFacets, 
+                 std::vector<cgVec3>& meshPoints,
+                 std::vector<int>& triangleCounts, float maxSinTheta,
+                 std::vector<std::vector<geo::Facet>>& targetLevels, std::vector<int>& actualSizes,
+                 std::vector<float>& achievedMaxLosses, const LODOptions& options = LODOptions() );
     
 };
 
@@ -46,6 +46,30 @@ float triArea(cgVec3 p1,cgVec3 p2,cgVec3 p3);
  */
 float triAspectRatio(cgVec3 p1,cgVec3 p2,cgVec3 p3);
 
+/**
+ * @brief Computes the area, aspect ratio and unit normal of n triangles in one sweep.
+ * Points are given as separate x, y and z streams, triangle t is made of points i0[t], i1[t], i2[t].
+ * Evaluates 16 triangles at a time with AVX-512 or 8 with AVX2 when the compiler targets them,
+ * the rest (or everything, without those instruction sets) goes through the scalar path.
+ * Computes the same quantities as triArea, triAspectRatio and faceNormal.
+ * 
+ * @param x 
+ * @param y 
+ * @param z 
+ * @param i0 
+ * @param i1 
+ * @param i2 
+ * @param n number of triangles
+ * @param area n outputs
+ * @param aspectRatio n outputs
+ * @param nx n outputs
+ * @param ny n outputs
+ * @param nz n outputs
+ */
+void triMetricsBatch(const float* x, const float* y, const float* z,
+                     const int* i0, const int* i1, const int* i2, int n,
+                     float* area, float* aspectRatio, float* nx, float* ny, float* nz);
+
 uint64_t hash(uint64_t value);
 
 /**
@@ -186,6 +210,45 @@ struct Facet{
     };
 };
 
+/**
+ * @brief Error quadric - symmetric 4x4 matrix Q such that [p 1]Q[p 1]^T is the sum of
+ * squared distances from p to a set of planes. Only the upper triangle is stored:
+ * a2 ab ac ad b2 bc bd c2 cd d2 for a plane ax+by+cz+d=0.
+ * 
+ */
+struct Quadric{
+    double q[10]={0,0,0,0,0,0,0,0,0,0};
+    Quadric(){}
+    /**
+     * @brief Quadric of the plane with unit normal n passing through p, scaled by weight
+     * 
+     * @param n 
+     * @param p 
+     * @param weight 
+     */
+    Quadric(cgVec3 n, cgVec3 p, double weight);
+    void add(const Quadric& b){for(int i = 0; i < 10; i++){q[i]+=b.q[i];}}
+    Quadric operator+(const Quadric& b) const {Quadric out = *this; out.add(b); return out;}
+
+    /**
+     * @brief Sum of squared (weighted) distances from p to the planes in this quadric
+     * 
+     * @param p 
+     * @return double 
+     */
+    double error(const cgVec3& p) const;
+};
+
+/**
+ * @brief Area weighted quadric of the plane through a triangle
+ * 
+ * @param p1 
+ * @param p2 
+ * @param p3 
+ * @return Quadric 
+ */
+Quadric facetQuadric(cgVec3& p1,cgVec3& p2,cgVec3& p3);
+
 /**
  * @brief Gets any shared edges between the 2 facets, if none are found, returns an edge with negative indices
  * 
@@ -215,5 +278,14 @@ void getHorizonEdges(std::vector<Facet>& facets, std::vector<Edge>& target);
  */
 void remapVertices(std::vector<Facet>& og_facets, std::vector<cgVec3>& og_vertices, std::vector<Facet>& new_facets, std::vector<cgVec3>& new_vertices);
 
+/**
+ * @brief Per vertex normals, the normalized sum of the face normals of the facets around each vertex
+ * 
+ * @param facets 
+ * @param vertices 
+ * @param normals one per vertex, unused vertices get a zero normal
+ */
+void vertexNormals(std::vector<Facet>& facets, std::vector<cgVec3>& vertices, std::vector<cgVec3>& normals);
+
 }
 #endif /* GEOMETRY */
@@ -14,33 +14,319 @@
 #include <vector>
 #include "UUID.hpp"
 #include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <algorithm>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define HASHTABLE_SSE2
+#endif
 
+/**
+ * @brief Mixes a 64 bit lookup value into a hash for FlatHashTable
+ * 
+ */
+struct HashKey64{
+    uint64_t operator()(uint64_t value) const {
+        uint64_t x = value;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+};
+
+/**
+ * @brief Mixes a 128 bit lookup value into a hash for FlatHashTable
+ * 
+ */
+struct HashKey128{
+    uint64_t operator()(const uuid128& value) const {
+        return HashKey64()(value.dat[0] ^ (value.dat[1]*0x9e3779b97f4a7c15ULL));
+    }
+};
+
+/**
+ * @brief Growable open addressing hash table shared by the HashTable classes.
+ * Slots are probed 16 at a time (Swiss table style): every slot has a control byte holding
+ * 7 bits of the hash, or a marker for empty and deleted slots, and a whole group of control
+ * bytes is compared at once with SSE2 when it is available.
+ * The slots hold indices into an array of elements, which keeps the elements in insertion order
+ * so iterating visits them in the order they were added. The table grows once it is 7/8 full.
+ * Lookup values must be unique, check with find before adding one which may already be in the table.
+ * While the elements are held (holdElements, done by the iterators of the HashTable classes) removed
+ * elements stay in place so element indices dont move under an iteration.
+ * 
+ * @tparam K lookup value type
+ * @tparam V stored value type
+ * @tparam Hasher maps a K to a 64 bit hash
+ */
+template <class K, class V, class Hasher>
+class FlatHashTable{
+    public:
+    struct element{
+        element(const V& value, const K& lookupValue){this->value = value; this->lookupValue=lookupValue; alive=true;}
+        V value;
+        K lookupValue;
+        bool alive; //false once removed, the element is dropped the next time the table is rebuilt
+    };
+
+    FlatHashTable(){
+        init(minCapacity);
+    }
+
+    /**
+     * @brief Construct a new table with room for about 2^log2Capacity elements before it has to grow
+     * 
+     * @param log2Capacity 
+     */
+    FlatHashTable(int log2Capacity){
+        int capacity = minCapacity;
+        while(capacity < (1 << std::min(std::max(log2Capacity,0),30))){
+            capacity <<= 1;
+        }
+        init(capacity);
+    }
+
+    void add(const V& value, const K& lookupValue){
+        if((size+nDeleted+1)*8 > capacity*7){
+            //grow unless most of the used slots are tombstones, then rebuilding in place is enough
+            rehash(size*2 >= capacity ? capacity*2 : capacity);
+        }
+        uint64_t h = Hasher()(lookupValue);
+        int slot = findFree(h);
+        //a reused DELETED slot can sit in front of an equal lookup value, which would then be shadowed
+        assert(ctrl[slot] != DELETED || findSlot(lookupValue) < 0);
+        placeSlot(slot,h,int(elements.size()));
+        elements.push_back(element(value,lookupValue));
+        size++;
+    }
+
+    /**
+     * @brief Returns the element index of lookupValue or -1 if it isnt in the table
+     * 
+     * @param lookupValue 
+     * @return int 
+     */
+    int find(const K& lookupValue){
+        int slot = findSlot(lookupValue);
+        return slot < 0 ? -1 : slots[slot];
+    }
+
+    V* getPtr(const K& lookupValue){
+        int slot = findSlot(lookupValue);
+        return slot < 0 ? NULL : &elements[slots[slot]].value;
+    }
+
+    /**
+     * @brief Removes the element at lookupValue, returns false if there was none
+     * 
+     * @param lookupValue 
+     * @param value receives the removed value
+     * @return true 
+     * @return false 
+     */
+    bool pop(const K& lookupValue, V& value){
+        int slot = findSlot(lookupValue);
+        if(slot < 0){
+            return false;
+        }
+        element& e = elements[slots[slot]];
+        value = e.value;
+        e.alive = false;
+        ctrl[slot] = DELETED;
+        nDeleted++;
+        nDead++;
+        size--;
+        //drop the removed elements once they are the majority
+        if(!held && nDead > 16 && nDead > size){
+            rehash(capacity);
+        }
+        return true;
+    }
+
+    /**
+     * @brief While hold is true removed elements arent dropped, so the element indices stay valid
+     * (growing only rebuilds the slots). Releasing drops them if they are the majority.
+     * 
+     * @param hold 
+     */
+    void holdElements(bool hold){
+        held = hold;
+        if(!held && nDead > 16 && nDead > size){
+            rehash(capacity);
+        }
+    }
+
+    int getSize(){return size;}
+
+    void clear(){
+        init(minCapacity);
+    }
+
+    //Elements by index, including removed ones (alive == false), in insertion order
+    int numElements(){return int(elements.size());}
+    element& getElement(int i){return elements[i];}
+
+    private:
+    static constexpr int groupSize = 16;
+    static constexpr int minCapacity = 16;
+    static constexpr int8_t EMPTY = -128;
+    static constexpr int8_t DELETED = -2;
+
+    std::vector<int8_t> ctrl; //per slot, 7 bits of the hash or EMPTY or DELETED
+    std::vector<int> slots; //per slot, index into elements
+    std::vector<element> elements;
+    int capacity = 0; //number of slots, a power of 2 and a multiple of groupSize
+    int size = 0; //live elements
+    int nDeleted = 0; //DELETED slots
+    int nDead = 0; //removed elements still in elements
+    bool held = false; //see holdElements
+
+    void init(int capacity){
+        initSlots(capacity);
+        elements.clear();
+        size = 0;
+        nDead = 0;
+        held = false;
+    }
+
+    void initSlots(int capacity){
+        this->capacity = capacity;
+        ctrl = std::vector<int8_t>(capacity,int8_t(EMPTY));
+        slots = std::vector<int>(capacity,-1);
+        nDeleted = 0;
+    }
+
+    //bit i is set when byte i of the group equals b
+    static uint32_t matchByte(const int8_t* group, int8_t b){
+#ifdef HASHTABLE_SSE2
+        __m128i g = _mm_loadu_si128((const __m128i*)group);
+        return uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(g,_mm_set1_epi8(b))));
+#else
+        uint32_t mask = 0;
+        for(int i = 0; i < groupSize; i++){
+            mask |= uint32_t(group[i] == b) << i;
+        }
+        return mask;
+#endif
+    }
+
+    //bit i is set when slot i of the group is EMPTY or DELETED (the only negative control bytes)
+    static uint32_t matchFree(const int8_t* group){
+#ifdef HASHTABLE_SSE2
+        return uint32_t(_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)group)));
+#else
+        uint32_t mask = 0;
+        for(int i = 0; i < groupSize; i++){
+            mask |= uint32_t(group[i] < 0) << i;
+        }
+        return mask;
+#endif
+    }
+
+    static int lowestBit(uint32_t mask){
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_ctz(mask);
+#else
+        int i = 0;
+        while(!(mask & 1)){
+            mask >>= 1;
+            i++;
+        }
+        return i;
+#endif
+    }
+
+    int findSlot(const K& lookupValue){
+        uint64_t h = Hasher()(lookupValue);
+        int8_t h2 = int8_t(h & 0x7F);
+        int nGroups = capacity/groupSize;
+        int g = int((h >> 7) & uint64_t(nGroups-1));
+        //triangular probing over the groups visits every group once
+        for(int step = 1; step <= nGroups; step++){
+            const int8_t* group = &ctrl[g*groupSize];
+            uint32_t mask = matchByte(group,h2);
+            while(mask){
+                int slot = g*groupSize + lowestBit(mask);
+                if(elements[slots[slot]].lookupValue == lookupValue){
+                    return slot;
+                }
+                mask &= mask-1;
+            }
+            if(matchByte(group,EMPTY)){
+                return -1; //lookupValue would have been placed in this group
+            }
+            g = (g+step) & (nGroups-1);
+        }
+        return -1;
+    }
+
+    int findFree(uint64_t h){
+        int nGroups = capacity/groupSize;
+        int g = int((h >> 7) & uint64_t(nGroups-1));
+        for(int step = 1; ; step++){
+            uint32_t mask = matchFree(&ctrl[g*groupSize]);
+            if(mask){
+                return g*groupSize + lowestBit(mask);
+            }
+            g = (g+step) & (nGroups-1);
+        }
+    }
+
+    void placeSlot(int slot, uint64_t h, int index){
+        if(ctrl[slot] == DELETED){
+            nDeleted--;
+        }
+        ctrl[slot] = int8_t(h & 0x7F);
+        slots[slot] = index;
+    }
+
+    //rebuilds the slots with newCapacity slots and drops removed elements (unless they are held), keeping the insertion order
+    void rehash(int newCapacity){
+        if(held){
+            initSlots(newCapacity);
+            for(int i = 0; i < int(elements.size()); i++){
+                if(elements[i].alive){
+                    uint64_t h = Hasher()(elements[i].lookupValue);
+                    placeSlot(findFree(h),h,i);
+                }
+            }
+            return;
+        }
+        std::vector<element> old;
+        old.swap(elements);
+        int live = size;
+        init(newCapacity);
+        elements.reserve(live);
+        for(element& e : old){
+            if(e.alive){
+                add(e.value,e.lookupValue);
+            }
+        }
+    }
+};
+
+/**
+ * @brief Hash table of pointers with 64 bit keys
+ * 
+ */
 struct HashTable{
-    HashTable(int log2Bins); //log2bins > # of bins = 2^log2bins
+    HashTable(int log2Bins); //log2bins > initial capacity = 2^log2bins, grows as needed
     ~HashTable();
     void add(void* value, uint64_t lookupValue); //lookup value is used to generate the hash to store value
     void* get(uint64_t lookupValue); //gets pointer at lookupValue
     void remove(uint64_t lookupValue); //removes element at lookupValue
     void* pop(uint64_t lookupValue); //gets pointer at lookupValue and removes it (faster than get then remove)
     uint32_t hash(uint64_t value);
-    int calcSize(); //calculates the number of elements in the table, dont do this every loop iteration if you care about performance...
-    void clear(); //removes all bins from table
-    //For iterating through hash table, will have more overhead than iterating through an array or vector
+    int calcSize(); //number of elements in the table
+    void clear(); //removes all elements from table
+    //For iterating through hash table, visits the elements in the order they were added.
+    //Elements can be removed while iterating, removed elements are only dropped once the iteration reaches the end
     void iterBegin(); //set iterator to first element
     void* iterGetNext(); //gets next hash table element, returns NULL at the end
-    struct element{
-        element(void* value, uint64_t lookupValue){this->value = value; this->lookupValue=lookupValue;}
-        void* value;
-        uint64_t lookupValue;
-    };
 private:
-    int log2Bins;
-    int numBins; //calculated from 1<<log2Bins, saved for convinience
-    std::vector<element>* bins; //ARRAY of vectors.
-    int size; //current size
-    //iterators
-    int iterBin=0; //index of bin
-    int iterInd=0; //index in vector
+    FlatHashTable<uint64_t,void*,HashKey64> table;
+    int iterInd=0; //index of the next element
 };
 
 /**
@@ -50,28 +336,15 @@ private:
  */
 template <class T> 
 class HashTable_s{
-    struct element{
-        element(T value, uint64_t lookupValue){this->value = value; this->lookupValue=lookupValue;}
-        T value;
-        uint64_t lookupValue;
-    };
     public:
 
-    HashTable_s(int log2Bins){
-        this->log2Bins = log2Bins;
-        this->numBins = 1<<log2Bins;
-        for (int i = 0; i < numBins; i++){
-            this->bins.push_back(std::vector<element>());
-        }
-        size=0;
+    HashTable_s(int log2Bins) : table(log2Bins) {
     }
 
     ~HashTable_s(){};
 
     void add(T value, uint64_t lookupValue){
-        size++;
-        uint32_t ind = hash(lookupValue);
-        bins[ind].push_back(element(value,lookupValue));
+        table.add(value,lookupValue);
     }
 
     /**
@@ -82,13 +355,7 @@ class HashTable_s{
      * @return false 
      */
     bool isIn(uint64_t lookupValue){
-        uint32_t ind = hash(lookupValue);
-        for(int i = 0; i < bins[ind].size(); i++){
-            if (bins[ind][i].lookupValue == lookupValue){
-                return true;
-            }
-        }
-        return false;
+        return table.find(lookupValue) >= 0;
     }
 
     /**
@@ -98,33 +365,18 @@ class HashTable_s{
      * @return T 
      */
     T get(uint64_t lookupValue){
-        uint32_t ind = hash(lookupValue);
-        for(int i = 0; i < bins[ind].size(); i++){
-            if (bins[ind][i].lookupValue == lookupValue){
-                return bins[ind][i].value;
-            }
-        }
-        return T();
+        T* value = table.getPtr(lookupValue);
+        return value ? *value : T();
     }
 
     T* getPtr(uint64_t lookupValue){
-        uint32_t ind = hash(lookupValue);
-        for(int i = 0; i < bins[ind].size(); i++){
-            if (bins[ind][i].lookupValue == lookupValue){
-                return &bins[ind][i].value;
-            }
-        }
-        return NULL;
+        return table.getPtr(lookupValue);
     }
 
     void remove(uint64_t lookupValue){
-        uint32_t ind = hash(lookupValue);
-        for(int i = 0; i < bins[ind].size(); i++){
-            if (bins[ind][i].lookupValue == lookupValue){
-                bins[ind].erase(bins[ind].begin()+i);
-                size--;
-                return;
-            }
+        T value;
+        if(table.pop(lookupValue,value)){
+            return;
         }
         std::cout << "ERROR: object missing from hash table_s...\n";
         exit(0);
@@ -132,28 +384,22 @@ class HashTable_s{
 
     
     uint32_t hash(uint64_t value){
-        uint32_t x = value;
-        x = ((x >> 16) ^ x) * 0x45d9f3b;
-        x = ((x >> 16) ^ x) * 0x45d9f3b;
-        x = (x >> 16) ^ x;
-        return (x>>(32-log2Bins));
+        return uint32_t(HashKey64()(value));
     }
 
     int getSize(){
-        return size;
+        return table.getSize();
     }
 
     void clear(){
-        size=0;
-        for (int i = 0; i < numBins; i++){
-            this->bins[i].clear();
-        }
+        table.clear();
     }
 
-    //For iterating through hash table, will have more overhead than iterating through an array or vector
+    //For iterating through hash table, visits the elements in the order they were added.
+    //Elements can be removed while iterating, removed elements are only dropped once the iteration reaches the end
     void iterBegin(){
-        iterBin=0;
-        iterInd=-1;
+        iterInd=0;
+        table.holdElements(true);
     }
 
     /**
@@ -165,37 +411,23 @@ class HashTable_s{
      */
 
     T iterGetNext(bool& isFinished){
-        if (iterInd >= int(bins[iterBin].size())-1 ) { //returned last element in bin
-            iterBin++;
-            while(iterBin < numBins){
-                if (bins[iterBin].size() == 0)
-                    iterBin++;
-                else
-                    break;
-            }
-            iterInd=0;
-        } else {
+        while(iterInd < table.numElements()){
+            typename FlatHashTable<uint64_t,T,HashKey64>::element& e = table.getElement(iterInd);
             iterInd++;
+            if(e.alive){
+                isFinished = false;
+                return e.value;
+            }
         }
-
-        if (iterBin >= numBins){
-            isFinished = true;
-            return T();
-        }
-
-        element elem = bins[iterBin][iterInd];
-        isFinished = false;
-        return elem.value;
+        isFinished = true;
+        table.holdElements(false);
+        return T();
     }
 
 private:
-    int log2Bins;
-    int numBins; //calculated from 1<<log2Bins, saved for convinience
-    std::vector<std::vector<element>> bins; //vector of vectors.
-    int size; //current size
+    FlatHashTable<uint64_t,T,HashKey64> table;
     //iterators
-    int iterBin=0; //index of bin
-    int iterInd=0; //index in vector
+    int iterInd=0; //index of the next element
 };
 
 /**
@@ -206,31 +438,17 @@ private:
  */
 template <class T> 
 class HashTable_s128{
-    struct element{
-        element(T value, uuid128 lookupValue){this->value = value; this->lookupValue=lookupValue;}
-        T value;
-        uuid128 lookupValue;
-    };
-    
     public:
 
     HashTable_s128(){}
 
-    HashTable_s128(int log2Bins){
-        this->log2Bins = log2Bins;
-        this->numBins = 1<<log2Bins;
-        for (int i = 0; i < numBins; i++){
-            this->bins.push_back(std::vector<element>());
-        }
-        size=0;
+    HashTable_s128(int log2Bins) : table(log2Bins) {
     }
 
     ~HashTable_s128(){};
 
     void add(T value, uuid128 lookupValue){
-        size++;
-        uint32_t ind = hash(lookupValue);
-        bins[ind].push_back(element(value,lookupValue));
+        table.add(value,lookupValue);
     }
 
     /**
@@ -241,13 +459,7 @@ class HashTable_s128{
      * @return false 
      */
     bool isIn(uuid128 lookupValue){
-        uint32_t ind = hash(lookupValue);
-        for(int i = 0; i < bins[ind].size(); i++){
-            if (bins[ind][i].lookupValue == lookupValue){
-                return true;
-            }
-        }
-        return false;
+        return table.find(lookupValue) >= 0;
     }
 
     /**
@@ -257,34 +469,18 @@ class HashTable_s128{
      * @return T 
      */
     T get(uuid128 lookupValue){
-        uint32_t ind = hash(lookupValue);
-        for(int i = 0; i < bins[ind].size(); i++){
-            if (bins[ind][i].lookupValue == lookupValue){
-                return bins[ind][i].value;
-            }
-        }
-        
-        return T();
+        T* value = table.getPtr(lookupValue);
+        return value ? *value : T();
     }
 
     T* getPtr(uuid128 lookupValue){
-        uint32_t ind = hash(lookupValue);
-        for(int i = 0; i < bins[ind].size(); i++){
-            if (bins[ind][i].lookupValue == lookupValue){
-                return &bins[ind][i].value;
-            }
-        }
-        return NULL;
+        return table.getPtr(lookupValue);
     }
 
     void remove(uuid128 lookupValue){
-        uint32_t ind = hash(lookupValue);
-        for(int i = 0; i < bins[ind].size(); i++){
-            if (bins[ind][i].lookupValue == lookupValue){
-                bins[ind].erase(bins[ind].begin()+i);
-                size--;
-                return;
-            }
+        T value;
+        if(table.pop(lookupValue,value)){
+            return;
         }
         std::cout << "ERROR: object missing from hash table_s...\n";
         assert(false);
@@ -293,28 +489,22 @@ class HashTable_s128{
 
     
     uint32_t hash(uuid128 value){
-        uint32_t x = uint32_t(value.dat[0] ^ value.dat[1]);
-        x = ((x >> 16) ^ x) * 0x45d9f3b;
-        x = ((x >> 16) ^ x) * 0x45d9f3b;
-        x = (x >> 16) ^ x;
-        return (x>>(32-log2Bins));
+        return uint32_t(HashKey128()(value));
     }
 
     int getSize(){
-        return size;
+        return table.getSize();
     }
 
     void clear(){
-        size=0;
-        for (int i = 0; i < numBins; i++){
-            this->bins[i].clear();
-        }
+        table.clear();
     }
 
-    //For iterating through hash table, will have more overhead than iterating through an array or vector
+    //For iterating through hash table, visits the elements in the order they were added.
+    //Elements can be removed while iterating, removed elements are only dropped once the iteration reaches the end
     void iterBegin(){
-        iterBin=0;
-        iterInd=-1;
+        iterInd=0;
+        table.holdElements(true);
     }
 
     /**
@@ -326,37 +516,23 @@ class HashTable_s128{
      */
 
     T iterGetNext(bool& isFinished){
-        if (iterInd >= int(bins[iterBin].size())-1 ) { //returned last element in bin
-            iterBin++;
-            while(iterBin < numBins){
-                if (bins[iterBin].size() == 0)
-                    iterBin++;
-                else
-                    break;
-            }
-            iterInd=0;
-        } else {
+        while(iterInd < table.numElements()){
+            typename FlatHashTable<uuid128,T,HashKey128>::element& e = table.getElement(iterInd);
             iterInd++;
+            if(e.alive){
+                isFinished = false;
+                return e.value;
+            }
         }
-
-        if (iterBin >= numBins){
-            isFinished = true;
-            return T();
-        }
-
-        element elem = bins[iterBin][iterInd];
-        isFinished = false;
-        return elem.value;
+        isFinished = true;
+        table.holdElements(false);
+        return T();
     }
 
 private:
-    int log2Bins;
-    int numBins; //calculated from 1<<log2Bins, saved for convinience
-    std::vector<std::vector<element>> bins; //vector of vectors.
-    int size; //current size
+    FlatHashTable<uuid128,T,HashKey128> table;
     //iterators
-    int iterBin=0; //index of bin
-    int iterInd=0; //index in vector
+    int iterInd=0; //index of the next element
 };
 
 /**
@@ -364,31 +540,22 @@ private:
  * 
  */
 struct HashTable128{
-    HashTable128(int log2Bins); //log2bins > # of bins = 2^log2bins
+    HashTable128(int log2Bins); //log2bins > initial capacity = 2^log2bins, grows as needed
     ~HashTable128();
     void add(void* value, uuid128 lookupValue); //lookup value is used to generate the hash to store value
     void* get(uuid128 lookupValue); //gets pointer at lookupValue
     void remove(uuid128 lookupValue); //removes element at lookupValue
     void* pop(uuid128 lookupValue); //gets pointer at lookupValue and removes it (faster than get then remove)
-    uint32_t hash(uuid128 value); //this hashes the value to get a bin to put it into
-    int calcSize(); //calculates the number of elements in the table, dont do this every loop iteration if you care about performance...
-    void clear(); //removes all bins from table
-    //For iterating through hash table, will have more overhead than iterating through an array or vector
+    uint32_t hash(uuid128 value); //this hashes the value
+    int calcSize(); //number of elements in the table
+    void clear(); //removes all elements from table
+    //For iterating through hash table, visits the elements in the order they were added.
+    //Elements can be removed while iterating, removed elements are only dropped once the iteration reaches the end
     void iterBegin(); //set iterator to first element
     void* iterGetNext(); //gets next hash table element, returns NULL at the end
-    struct element{
-        element(void* value, uuid128 lookupValue){this->value = value; this->lookupValue=lookupValue;}
-        void* value;
-        uuid128 lookupValue;
-    };
 private:
-    int log2Bins;
-    int numBins; //calculated from 1<<log2Bins, saved for convinience
-    std::vector<element>* bins; //ARRAY of vectors.
-    int size; //current size
-    //iterators
-    int iterBin=0; //index of bin
-    int iterInd=0; //index in vector
+    FlatHashTable<uuid128,void*,HashKey128> table;
+    int iterInd=0; //index of the next element
 };
 
 
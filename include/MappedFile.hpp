@@ -0,0 +1,40 @@
+//Read only view of a whole file, memory mapped where the platform allows it
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Maps a file read only into memory so it can be parsed in place (and by several threads at once)
+ * without copying it through stdio buffers. On platforms without mmap the file is read into memory instead.
+ *
+ */
+class MappedFile{
+    public:
+    MappedFile(){}
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator = (const MappedFile&) = delete;
+
+    /**
+     * @brief Maps filename, closing any file which was mapped before
+     *
+     * @param filename
+     * @return false if the file couldnt be opened or mapped
+     */
+    bool open(const std::string& filename);
+    void close();
+
+    const char* data(){return bytes;}
+    size_t size(){return nBytes;}
+
+    private:
+    const char* bytes = nullptr;
+    size_t nBytes = 0;
+    bool mapped = false; //bytes points into an mmap rather than into buffer
+    std::vector<char> buffer;
+};
+
+#endif /* MAPPEDFILE_HPP */
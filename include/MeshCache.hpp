@@ -0,0 +1,128 @@
+//Binary container for loaded meshes, so a file only has to be parsed once. The arrays of every object are stored
+//exactly as they are laid out in memory and can be used straight out of the mapped file.
+#ifndef MESHCACHE_HPP
+#define MESHCACHE_HPP
+
+#include "MeshLoader.hpp"
+#include "MappedFile.hpp"
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/*
+ * File layout (little endian, every array starts on a 16 byte boundary):
+ *   MeshCacheHeader
+ *   MeshCacheRecord x nObjects
+ *   per object: positions (cgVec3 x nVertices), normals (cgVec3 x nVertices), textCoords (cgVec2 x nVertices),
+ *               indices (int32 x nIndices), then the name, material name, mtllib and filename strings
+ */
+
+#define MESH_CACHE_MAGIC "AUTOLODM"
+#define MESH_CACHE_VERSION 1
+#define MESH_CACHE_EXTENSION ".amc"
+
+struct MeshCacheHeader{
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder; //0x01020304 as written, a cache from a machine with the other byte order is rejected
+    uint32_t nObjects;
+    uint32_t unused;
+    uint64_t fileSize; //catches truncated files
+    uint64_t sourceSize; //size and modification time of the file the cache was made from, 0 if none
+    int64_t sourceTime;
+};
+
+//byte offsets from the start of the file and element counts of one object
+struct MeshCacheRecord{
+    uint64_t nVertices;
+    uint64_t nIndices;
+    uint64_t positions;
+    uint64_t normals;
+    uint64_t textCoords;
+    uint64_t indices;
+    uint64_t name, nameLength;
+    uint64_t matName, matNameLength;
+    uint64_t mtllib, mtllibLength;
+    uint64_t filename, filenameLength;
+};
+
+//one object of an open MeshCache, the arrays point into the mapped file
+struct MeshCacheObject{
+    std::string name;
+    std::string matName;
+    std::string mtllib;
+    std::string filename;
+    const cgVec3* positions = nullptr;
+    const cgVec3* normals = nullptr;
+    const cgVec2* textCoords = nullptr;
+    int nVertices = 0;
+    const int* indices = nullptr;
+    int nIndices = 0;
+};
+
+/**
+ * @brief Read only view of a mesh cache file. Nothing is parsed or copied, the object arrays are used in place
+ * and stay valid until the cache is closed.
+ *
+ */
+class MeshCache{
+    public:
+    /**
+     * @brief Maps filename and checks its header, that every array lies inside the file and that the indices
+     * of every object make whole facets of its own vertices
+     *
+     * @param filename
+     * @return false if the file couldnt be opened or isnt a valid cache
+     */
+    bool open(const std::string& filename);
+    void close();
+
+    /**
+     * @brief Copies every object into new objItems appended to target, a plain copy of the arrays
+     *
+     * @param target
+     */
+    void load(std::vector<objItem*>& target);
+
+    int numObjects(){return int(objects.size());}
+    const MeshCacheObject& object(int i){return objects[i];}
+    uint64_t sourceSize(){return srcSize;}
+    int64_t sourceTime(){return srcTime;}
+
+    private:
+    MappedFile file;
+    std::vector<MeshCacheObject> objects;
+    uint64_t srcSize = 0;
+    int64_t srcTime = 0;
+};
+
+/**
+ * @brief Writes items as a mesh cache, through a temporary file which is renamed over filename
+ * so readers never see a partly written cache
+ *
+ * @param filename
+ * @param items
+ * @param sourceSize size of the file the items were loaded from, 0 if none
+ * @param sourceTime modification time of that file
+ * @return false if the file couldnt be written
+ */
+bool writeMeshCache(const std::string& filename, std::vector<objItem*>& items, uint64_t sourceSize = 0, int64_t sourceTime = 0);
+
+/**
+ * @brief Loads every object of a mesh cache into new objItems (a plain copy of the arrays, no parsing)
+ *
+ * @param filename
+ * @param target
+ * @return false if filename isnt a valid cache, target is left unchanged
+ */
+bool loadMeshCache(const std::string& filename, std::vector<objItem*>& target);
+
+/**
+ * @brief Path of the cache kept next to a source mesh file
+ *
+ * @param filename
+ * @return std::string
+ */
+std::string meshCachePath(const std::string& filename);
+
+#endif /* MESHCACHE_HPP */
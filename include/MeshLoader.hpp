@@ -57,7 +57,8 @@ struct objItem{
  * @brief Loads data from a .obj file into target vectors
  * vertex targets = a vector of vectors (one vector per object )containing positions,
  * normals and texture coordinates describing the object.
- * each vertex is a unique (per object) set of positions normals and texture coords
+ * each vertex is a unique (per object) set of positions normals and texture coords,
+ * numbered in the order it first appears in the facets (large objects are deduplicated on every hardware thread)
  * 
  * the indextargets is filled with a vector per object, describing the 
  * 
@@ -69,5 +70,70 @@ struct objItem{
 void loadOBJFile(std::string filename, 
                  std::vector<objItem*>& target, std::string object_id);
 
+/**
+ * @brief Same as loadOBJFile (and produces the same objItems) for large files: the file is memory mapped,
+ * split into chunks at line boundaries and the v/vt/vn/f records of the chunks are parsed on nThreads threads.
+ * The chunks are then stitched back together in file order and the objects are assembled concurrently.
+ * 
+ * @param filename 
+ * @param target
+ * @param objName name used to tag textures
+ * @param nThreads threads used to parse, 0 uses one per hardware thread
+ * @param error if not nullptr, receives why the file couldnt be loaded
+ * @return false if the file couldnt be opened or isnt a triangulated obj file with v/vt/vn corners
+ * which all exist, target is left unchanged
+ */
+bool loadOBJFileMapped(std::string filename, 
+                 std::vector<objItem*>& target, std::string object_id, int nThreads = 0, std::string* error = nullptr);
+
+/**
+ * @brief Loads a binary little endian PLY file as one object. Vertex x/y/z, nx/ny/nz and u/v (or s/t) properties
+ * of any type are read, packed float positions and all triangle faces (uchar count, int indices) are copied in bulk
+ * and other faces are split into fans. Missing normals are computed from the facets and missing texture coordinates are zero.
+ * 
+ * @param filename 
+ * @param target
+ * @param objName name used to tag textures
+ * @param nThreads threads used to convert the vertices, 0 uses one per hardware thread
+ * @param error if not nullptr, receives why the file couldnt be loaded
+ * @return false if the file couldnt be opened, is truncated or isnt a supported PLY file, target is left unchanged
+ */
+bool loadPLYFile(std::string filename, 
+                 std::vector<objItem*>& target, std::string object_id, int nThreads = 0, std::string* error = nullptr);
+
+/**
+ * @brief Loads a binary STL file as one object. The triangles are welded at bit identical corner positions,
+ * so the facets share vertices like an indexed mesh (numbered in order of first appearance). Triangles which weld
+ * down to an edge or a point and repeats of an earlier triangle are dropped.
+ * Normals are computed from the facets and texture coordinates are zero.
+ * 
+ * @param filename 
+ * @param target
+ * @param objName name used to tag textures
+ * @param error if not nullptr, receives why the file couldnt be loaded
+ * @return false if the file couldnt be opened or isnt a binary STL file, target is left unchanged
+ */
+bool loadSTLFile(std::string filename, 
+                 std::vector<objItem*>& target, std::string object_id, std::string* error = nullptr);
+
+/**
+ * @brief Loads a mesh file by its extension: mesh caches (.amc, see MeshCache.hpp) are copied straight out of the
+ * mapped file, .ply and .stl files go through loadPLYFile and loadSTLFile and anything else is read as obj
+ * with loadOBJFileMapped.
+ * With useCache a mesh file is read from the cache next to it (meshCachePath) when the cache was made from a file
+ * of the same size and modification time, otherwise the file is parsed and the cache is written for the next load.
+ * 
+ * @param filename 
+ * @param target
+ * @param objName name used to tag textures
+ * @param useCache
+ * @param nThreads threads used to parse, 0 uses one per hardware thread
+ * @param error if not nullptr, receives why the file couldnt be loaded
+ * @return false if the file couldnt be loaded, target is left unchanged. Unlike loadOBJFile a bad file
+ * never ends the process, so a batch can skip it and carry on
+ */
+bool loadMesh(std::string filename, 
+                 std::vector<objItem*>& target, std::string object_id, bool useCache = false, int nThreads = 0, std::string* error = nullptr);
+
 
 #endif /* MESHLOADER */
@@ -0,0 +1,31 @@
+//Writes meshes (typically the result of AutoLOD::genLODMesh after geo::remapVertices) to obj files
+#ifndef MESHWRITER_HPP
+#define MESHWRITER_HPP
+
+#include "Geometry.hpp"
+#include <string>
+#include <vector>
+
+//one object of an obj file
+struct OBJWriteItem{
+    std::string name;
+    std::vector<geo::Facet>* facets = nullptr;
+    std::vector<cgVec3>* points = nullptr;
+    std::vector<cgVec3>* normals = nullptr; //one per point (see geo::vertexNormals), nullptr writes positions only
+};
+
+/**
+ * @brief Writes the objects to an obj file, every object gets an "o" line followed by its v, vn and f lines
+ * (faces as v//vn, or just v without normals, which loadOBJFile and loadOBJFileMapped read back).
+ * Blanks in a name become underscores and an object without a name is written as objectN.
+ * The lines are formatted in blocks straight into preallocated buffers (floats as the shortest text which reads
+ * back to the same value), the blocks are formatted on nThreads threads and written out in order.
+ *
+ * @param filename
+ * @param items
+ * @param nThreads threads used to format, 0 uses one per hardware thread
+ * @return false if the file couldnt be written
+ */
+bool writeOBJFile(const std::string& filename, std::vector<OBJWriteItem>& items, int nThreads = 0);
+
+#endif /* MESHWRITER_HPP */
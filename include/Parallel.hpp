@@ -0,0 +1,73 @@
+//Tools for splitting work across threads
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+
+namespace par{
+
+/**
+ * @brief Number of threads to actually use for a requested thread count,
+ * anything less than 1 means one thread per hardware thread
+ *
+ * @param requested
+ * @return int
+ */
+inline int numThreads(int requested){
+    if(requested > 0){
+        return requested;
+    }
+    int hw = int(std::thread::hardware_concurrency());
+    return hw > 0 ? hw : 1;
+}
+
+/**
+ * @brief Calls f(i, threadIndex) for every i in [0,n) using nThreads threads (including the calling thread).
+ * Indices are handed out in blocks of grainSize so uneven work still balances,
+ * threadIndex is in [0,nThreads) and can be used to index per thread buffers.
+ *
+ * @tparam F
+ * @param n
+ * @param nThreads
+ * @param f
+ * @param grainSize
+ */
+template <class F>
+void parallelFor(int n, int nThreads, F f, int grainSize = 64){
+    if(nThreads <= 1 || n <= grainSize){
+        for(int i = 0; i < n; i++){
+            f(i,0);
+        }
+        return;
+    }
+
+    std::atomic<int> next(0);
+    auto worker = [&](int threadIndex){
+        while(1){
+            int begin = next.fetch_add(grainSize);
+            if(begin >= n){
+                return;
+            }
+            int end = std::min(n,begin+grainSize);
+            for(int i = begin; i < end; i++){
+                f(i,threadIndex);
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for(int t = 1; t < nThreads; t++){
+        threads.push_back(std::thread(worker,t));
+    }
+    worker(0);
+    for(std::thread& t : threads){
+        t.join();
+    }
+}
+
+}
+
+#endif /* PARALLEL_HPP */
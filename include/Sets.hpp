@@ -1,6 +1,9 @@
 //Tools for manipulating sets
+#ifndef SETS_HPP
+#define SETS_HPP
 #include "HashTable.hpp"
 #include <vector>
+#include <math.h>
 
 /**
  * @brief Finds the union between the two sets, with each unique element enumerated exactly once
@@ -69,4 +72,6 @@ void setDiff(std::vector<T>& set1, std::vector<T>& set2, std::vector<T>& target)
             target.push_back(curr);
         }
     }
-}
\ No newline at end of file
+}
+
+#endif /* SETS_HPP */
@@ -1,6 +1,7 @@
 #ifndef VECTOR
 #define VECTOR
 #include <iostream>
+#include <math.h>
 
 /**
  * @brief A pared down vector library
@@ -78,9 +79,13 @@ cgMat4 projectionMatrixSimple(float aspect, float fov, float n, float f);
 
 cgMat4 lookAt(cgVec3 eye, cgVec3 center, cgVec3 up);
 
-cgVec3 cross(const cgVec3& v1, const cgVec3& v2);
+inline cgVec3 cross(const cgVec3& v1, const cgVec3& v2){
+    return cgVec3(v1.y * v2.z - v1.z * v2.y, v1.z * v2.x - v1.x * v2.z, v1.x * v2.y - v1.y * v2.x);
+}
 
-float dot(cgVec3 v1,cgVec3 v2);
+inline float dot(const cgVec3& v1, const cgVec3& v2){
+    return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z;
+}
 
 cgMat4 rotation(cgVec3 axis, float theta);
 
@@ -0,0 +1,32 @@
+//Grid vertex clustering, a fast first reduction for very large meshes before the edge collapses
+#ifndef VERTEXCLUSTERING_HPP
+#define VERTEXCLUSTERING_HPP
+
+#include "Geometry.hpp"
+#include <vector>
+
+namespace AutoLOD{
+
+    /**
+     * @brief Reduces the mesh towards targetSize vertices by snapping the vertices to a uniform grid and
+     * merging each connected piece of the surface inside a cell into its vertex closest to the mean of the piece.
+     * The result still indexes meshPoints. Horizon vertices are never merged so the outline stays where
+     * AutoLODGraph expects it. Clusters whose merge would leave a non-manifold edge or vertex or flip a facet
+     * are split into their octants (and eventually back into single vertices) until nothing is broken,
+     * so the result is as manifold as the input and can be handed to AutoLODGraph.
+     * Every round (grid sizing, merge and check) is linear in the mesh size, with the per facet and per vertex
+     * work spread across nThreads, and only a few rounds are needed in practice.
+     *
+     * @param meshFacets
+     * @param meshPoints
+     * @param targetSize number of vertices the grid is sized for, the split clusters add to it
+     * @param nThreads
+     * @param target receives the facets which survive the clustering
+     * @param targetIds index in meshFacets of each facet in target
+     */
+    void clusterVertices(std::vector<geo::Facet>& meshFacets, std::vector<cgVec3>& meshPoints, int targetSize, int nThreads,
+                         std::vector<geo::Facet>& target, std::vector<int>& targetIds);
+
+};
+
+#endif /* VERTEXCLUSTERING_HPP */
@@ -184,22 +184,30 @@ void MeshViewerApp::loadMesh(std::string objFilename){
 }
 
 void MeshViewerApp::simplifyMeshes(float compressionfactor, float maxSinTheta){
-    
-    for (objItem* og_item : data.original_meshes){
-        std::vector<geo::Facet> facets = std::vector<geo::Facet>(og_item->indices.size()/3);
+    //the objects are independent, simplify all of them at once and upload the results afterwards
+    std::vector<std::vector<geo::Facet>> facets = std::vector<std::vector<geo::Facet>>(data.original_meshes.size());
+    std::vector<AutoLOD::LODBatchItem> batch = std::vector<AutoLOD::LODBatchItem>(data.original_meshes.size());
+    for (int m = 0; m < data.original_meshes.size(); m++){
+        objItem* og_item = data.original_meshes[m];
+        facets[m] = std::vector<geo::Facet>(og_item->indices.size()/3);
 
         for(int i = 0; i < og_item->indices.size()/3; i++){
-            facets[i] = geo::Facet(og_item->indices[i*3+0],og_item->indices[i*3+1],og_item->indices[i*3+2]);
+            facets[m][i] = geo::Facet(og_item->indices[i*3+0],og_item->indices[i*3+1],og_item->indices[i*3+2]);
         }
+        batch[m].facets = &facets[m];
+        batch[m].points = &og_item->positions;
+        batch[m].compressionFactor = compressionfactor;
+    }
+    AutoLOD::genLODMeshes(batch,maxSinTheta);
 
-        std::vector<geo::Facet> simplified_facets;
+    for (int m = 0; m < data.original_meshes.size(); m++){
+        objItem* og_item = data.original_meshes[m];
+        std::vector<geo::Facet>& simplified_facets = batch[m].result;
         std::vector<geo::Facet> result_facets;
-        std::vector<geo::Facet> result_facets_trash;
         std::vector<cgVec3> result_points;
 
-        int actualSize;
-        AutoLOD::genLODMesh(facets,og_item->positions,simplified_facets,compressionfactor,maxSinTheta,actualSize);
-        std::cout << "Actual size: "<<actualSize<<"\n";
+        std::cout << og_item->name<<" actual size: "<<batch[m].actualSize<<"\n";
+        std::cout << "Max loss: "<<batch[m].achievedMaxLoss<<"\n";
 
         geo::remapVertices(simplified_facets,og_item->positions,result_facets,result_points);
 
@@ -210,24 +218,8 @@ void MeshViewerApp::simplifyMeshes(float compressionfactor, float maxSinTheta){
             indices[i*3+2]=result_facets[i].inds[2];
         }
         //recalculate normals
-        std::vector<cgVec3> result_normals = std::vector<cgVec3>(result_points.size());
-        for(int i = 0; i < result_normals.size(); i++){
-            result_normals[i] = cgVec3(0,0,0);
-        }
-        for (int i = 0; i < result_facets.size(); i++){
-            cgVec3 p0 = result_points[result_facets[i].inds[0]];
-            cgVec3 p1 = result_points[result_facets[i].inds[1]];
-            cgVec3 p2 = result_points[result_facets[i].inds[2]];
-            cgVec3 normal = geo::faceNormal(p0,p1,p2);
-            result_normals[result_facets[i].inds[0]] = result_normals[result_facets[i].inds[0]]+normal;
-            result_normals[result_facets[i].inds[1]] = result_normals[result_facets[i].inds[1]]+normal;
-            result_normals[result_facets[i].inds[2]] = result_normals[result_facets[i].inds[2]]+normal;
-
-        }
-        for (int i = 0; i < result_normals.size(); i++){
-            result_normals[i].normalize();
-        
-        }
+        std::vector<cgVec3> result_normals;
+        geo::vertexNormals(result_facets,result_points,result_normals);
 
         MeshGPUBuffer* newbuff = generateRenderBuffer(result_points,result_normals,indices);
         // MeshGPUBuffer* newbuff = generateRenderBuffer(og_item->positions,og_item->normals,indices);
@@ -0,0 +1,97 @@
+#include "Arena.hpp"
+#include <cstdlib>
+#include <algorithm>
+
+Arena::Arena(size_t blockSize){
+    this->blockSize = std::max(blockSize,size_t(4096));
+}
+
+Arena::~Arena(){
+    release();
+}
+
+int Arena::sizeClass(size_t bytes){
+    int c = 0;
+    size_t size = minClassSize;
+    while(size < bytes){
+        size <<= 1;
+        c++;
+    }
+    return c;
+}
+
+void* Arena::allocate(size_t bytes){
+    if(bytes == 0){
+        bytes = 1;
+    }
+    if(bytes > blockSize/2){
+        void* p = std::malloc(bytes);
+        if(!p){
+            throw std::bad_alloc();
+        }
+        largeBlocks.push_back(p);
+        reserved += bytes;
+        return p;
+    }
+
+    int c = sizeClass(bytes);
+    if(freeLists[c]){
+        FreeBlock* b = freeLists[c];
+        freeLists[c] = b->next;
+        return b;
+    }
+
+    size_t size = minClassSize << c;
+    if(cur == nullptr || size_t(end-cur) < size){
+        cur = (char*)std::malloc(blockSize);
+        if(!cur){
+            throw std::bad_alloc();
+        }
+        end = cur+blockSize;
+        blocks.push_back(cur);
+        reserved += blockSize;
+    }
+    void* p = cur;
+    cur += size;
+    return p;
+}
+
+void Arena::deallocate(void* p, size_t bytes){
+    if(p == nullptr){
+        return;
+    }
+    if(bytes == 0){
+        bytes = 1;
+    }
+    if(bytes > blockSize/2){
+        //there are only ever a few of these, one per big array
+        std::vector<void*>::iterator it = std::find(largeBlocks.begin(),largeBlocks.end(),p);
+        if(it != largeBlocks.end()){
+            std::free(p);
+            largeBlocks.erase(it);
+            reserved -= bytes;
+        }
+        return;
+    }
+    int c = sizeClass(bytes);
+    FreeBlock* b = (FreeBlock*)p;
+    b->next = freeLists[c];
+    freeLists[c] = b;
+}
+
+void Arena::release(){
+    for(char* b : blocks){
+        std::free(b);
+    }
+    for(void* b : largeBlocks){
+        std::free(b);
+    }
+    blocks.clear();
+    largeBlocks.clear();
+    cur = nullptr;
+    end = nullptr;
+    reserved = 0;
+    for(int c = 0; c < nClasses; c++){
+        freeLists[c] = nullptr;
+    }
+}
@@ -1,15 +1,98 @@
 #include "AutoLOD.hpp"
+#include "VertexClustering.hpp"
+#include "Parallel.hpp"
+#include <cmath>
 #include <limits>
-#include <set>
+#include <chrono>
+#ifndef _WIN64
+#include <sys/resource.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+size_t AutoLOD::peakRSS(){
+#ifdef _WIN64
+    return 0;
+#else
+#ifdef __linux__
+    //VmHWM follows resetPeakRSS, ru_maxrss doesnt
+    FILE* status = fopen("/proc/self/status","r");
+    if(status){
+        char line[256];
+        size_t hwm = 0;
+        while(fgets(line,sizeof(line),status)){
+            if(strncmp(line,"VmHWM:",6) == 0){
+                hwm = size_t(strtoull(line+6,nullptr,10))*1024; //kilobytes
+                break;
+            }
+        }
+        fclose(status);
+        if(hwm > 0){
+            return hwm;
+        }
+    }
+#endif
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF,&usage) != 0){
+        return 0;
+    }
+#ifdef __APPLE__
+    return size_t(usage.ru_maxrss); //bytes on macOS
+#else
+    return size_t(usage.ru_maxrss)*1024; //kilobytes on Linux
+#endif
+#endif
+}
+
+bool AutoLOD::resetPeakRSS(){
+#ifdef __linux__
+    FILE* clearRefs = fopen("/proc/self/clear_refs","w");
+    if(!clearRefs){
+        return false;
+    }
+    bool ok = fputs("5",clearRefs) >= 0;
+    return fclose(clearRefs) == 0 && ok;
+#else
+    return false;
+#endif
+}
 
-float AutoLOD::AutoLODGraphNode::getLoss(std::vector<cgVec3>& points){
+/**
+ * @brief Start time of a phase, resets the peak RSS first when stats measures it per phase
+ * 
+ * @param stats can be nullptr
+ * @return std::chrono::steady_clock::time_point 
+ */
+static std::chrono::steady_clock::time_point startPhase(AutoLOD::LODStats* stats){
+    if(stats && stats->phasePeakRSS){
+        AutoLOD::resetPeakRSS();
+    }
+    return std::chrono::steady_clock::now();
+}
+
+/**
+ * @brief Adds the time since start to phase and raises its peak RSS to the current one, returns the time added
+ * 
+ * @param phase 
+ * @param start 
+ * @return double 
+ */
+static double endPhase(AutoLOD::LODPhaseStats& phase, std::chrono::steady_clock::time_point start){
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    phase.seconds += seconds;
+    phase.peakRSS = std::max(phase.peakRSS,AutoLOD::peakRSS());
+    return seconds;
+}
+
+float AutoLOD::AutoLODGraph::getLoss(std::vector<cgVec3>& points, int v){
     float loss = 0.0;
     float area = 0.0;
-    std::vector<cgVec3> normals = std::vector<cgVec3>(facets.size());
+    std::vector<cgVec3> normals;
     int i = 0;
-    for(geo::Facet f : facets){
-        normals[i] = geo::faceNormal(points[f.inds[0]],points[f.inds[1]],points[f.inds[2]]);
-        area += geo::triArea(points[f.inds[0]],points[f.inds[1]],points[f.inds[2]]);
+    for(int c = vertCorner[v]; c >= 0; c = cornerNext[c]){
+        normals.push_back(getFacetNormal(c/3));
+        area += facetArea[c/3];
         i++;
     }
     cgVec3 meanNormal = {0,0,0};
@@ -27,227 +110,304 @@ float AutoLOD::AutoLODGraphNode::getLoss(std::vector<cgVec3>& points){
     return area*stdevNormal.norm();
 }
 
-AutoLOD::AutoLODGraph::AutoLODGraph(std::vector<geo::Facet>& facets, std::vector<cgVec3>& points){
-    int nPts = int(points.size());
-    double logPts = log2(float(nPts));
-    int nBins = int(logPts);
-    if(nBins < 1){
-        nBins = 1;
+void AutoLOD::AutoLODGraph::updateFacetGeometry(int f){
+    geo::Facet& tri = facets[f];
+    geo::triMetricsBatch(ptsX.data(),ptsY.data(),ptsZ.data(),&tri.inds[0],&tri.inds[1],&tri.inds[2],1,
+                         &facetArea[f],&facetAspectRatio[f],&facetNormalX[f],&facetNormalY[f],&facetNormalZ[f]);
+}
+
+/**
+ * @brief Triangles of a one-ring gathered for geo::triMetricsBatch.
+ * Each thread keeps one so getEcols can run concurrently without allocating on every call.
+ * 
+ */
+struct RingBatch{
+    std::vector<int> facet; //facet each triangle replaces
+    std::vector<int> i0;
+    std::vector<int> i1;
+    std::vector<int> i2;
+    std::vector<float> area;
+    std::vector<float> aspectRatio;
+    std::vector<float> nx;
+    std::vector<float> ny;
+    std::vector<float> nz;
+
+    void clear(){
+        facet.clear(); i0.clear(); i1.clear(); i2.clear();
     }
 
-    this->nodes = new HashTable128(nBins);
+    void push(int f, geo::Facet& tri){
+        facet.push_back(f);
+        i0.push_back(tri.inds[0]);
+        i1.push_back(tri.inds[1]);
+        i2.push_back(tri.inds[2]);
+    }
 
-    ptsCopy = points;
+    int size(){return int(facet.size());}
 
-    for (geo::Facet f : facets){
-        
-        for (int i = 0 ; i < 3; i++){
-            
-            AutoLODGraphNode* thisNode = (AutoLODGraphNode*)this->nodes->get(uuid128(f.inds[i]));
-            
-            if(thisNode == NULL){ //make a new node
-                thisNode = new AutoLODGraphNode(f.inds[i]);
-                this->nodes->add((void*)thisNode,uuid128(f.inds[i]));
-            }
+    void evaluate(AutoLOD::AutoLODGraph& graph){
+        int n = size();
+        area.resize(n); aspectRatio.resize(n); nx.resize(n); ny.resize(n); nz.resize(n);
+        geo::triMetricsBatch(graph.ptsX.data(),graph.ptsY.data(),graph.ptsZ.data(),i0.data(),i1.data(),i2.data(),n,
+                             area.data(),aspectRatio.data(),nx.data(),ny.data(),nz.data());
+    }
+};
+
+/**
+ * @brief Buffers reused by every call on the same thread so the inner loops of the simplifier dont allocate
+ * 
+ */
+struct Scratch{
+    RingBatch ring; //ecolIsLegal and getEcolLoss
+    std::vector<int> neighbors; //getEcols
+    std::vector<int> keepNeighbors; //ecolIsLegal
+    std::vector<int> removeNeighbors; //ecolIsLegal
+    std::vector<int> collFacets; //ecol
+    std::vector<int> affected; //ecol
+};
+static thread_local Scratch scratch;
+
+AutoLOD::AutoLODGraph::AutoLODGraph(std::vector<geo::Facet>& facets, std::vector<cgVec3>& points, bool useArena){
+    int nPts = int(points.size());
+    int nFacets = int(facets.size());
+
+    if(useArena){
+        arena = std::unique_ptr<Arena>(new Arena());
+    }
+    ArenaAllocator<int> alloc = ArenaAllocator<int>(arena.get());
 
-            thisNode->facets.insert(f);
+    ptsCopy = points;
+    ptsX = ArenaVector<float>(nPts,alloc);
+    ptsY = ArenaVector<float>(nPts,alloc);
+    ptsZ = ArenaVector<float>(nPts,alloc);
+    for(int i = 0; i < nPts; i++){
+        ptsX[i] = points[i].x;
+        ptsY[i] = points[i].y;
+        ptsZ[i] = points[i].z;
+    }
 
-            for(int j = 0; j < 3; j++){ //add adjacent nodes and edges related to this facet
-                if(i != j){
-                    thisNode->adjacentNodes.insert(f.inds[j]);
-                }
-            }
+    this->facets = ArenaVector<geo::Facet>(facets.begin(),facets.end(),alloc);
+    facetAlive = ArenaVector<uint8_t>(nFacets,1,alloc);
+    cornerNext = ArenaVector<int>(nFacets*3,-1,alloc);
+    vertCorner = ArenaVector<int>(nPts,-1,alloc);
+    vertAlive = ArenaVector<uint8_t>(nPts,0,alloc);
+    wasAffected = ArenaVector<uint8_t>(nPts,0,alloc);
+    stamp = ArenaVector<int>(nPts,0,alloc);
+    nCandidates = ArenaVector<int>(nPts,0,alloc);
+    quadrics = ArenaVector<geo::Quadric>(alloc);
+
+    facetNormalX = ArenaVector<float>(nFacets,alloc);
+    facetNormalY = ArenaVector<float>(nFacets,alloc);
+    facetNormalZ = ArenaVector<float>(nFacets,alloc);
+    facetArea = ArenaVector<float>(nFacets,alloc);
+    facetAspectRatio = ArenaVector<float>(nFacets,alloc);
+    std::vector<int> i0 = std::vector<int>(nFacets);
+    std::vector<int> i1 = std::vector<int>(nFacets);
+    std::vector<int> i2 = std::vector<int>(nFacets);
+    for (int f = 0; f < nFacets; f++){
+        i0[f] = facets[f].inds[0];
+        i1[f] = facets[f].inds[1];
+        i2[f] = facets[f].inds[2];
+    }
+    geo::triMetricsBatch(ptsX.data(),ptsY.data(),ptsZ.data(),i0.data(),i1.data(),i2.data(),nFacets,
+                         facetArea.data(),facetAspectRatio.data(),facetNormalX.data(),facetNormalY.data(),facetNormalZ.data());
 
+    for (int f = 0; f < nFacets; f++){
+        for (int i = 0 ; i < 3; i++){
+            int v = facets[f].inds[i];
+            vertAlive[v] = 1;
+            //push corner onto the vertex list
+            cornerNext[f*3+i] = vertCorner[v];
+            vertCorner[v] = f*3+i;
         }
     }
 
+    std::chrono::steady_clock::time_point horizonStart = std::chrono::steady_clock::now();
     std::vector<geo::Edge> horizonEdgeVec;
     geo::getHorizonEdges(facets,horizonEdgeVec);
+    horizonVert = ArenaVector<uint8_t>(nPts,0,alloc);
 
     // std::cout << "horizon edges: \n";
     for(geo::Edge e : horizonEdgeVec){
         // e.print();
-        this->horizonEdges.insert(e);
-        horizonVerts.insert(e.inds[0]);
-        horizonVerts.insert(e.inds[1]);
+        horizonVert[e.inds[0]] = 1;
+        horizonVert[e.inds[1]] = 1;
     }
+    horizonSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-horizonStart).count();
 
     // exit(-1);
 }
 
-void AutoLOD::AutoLODGraph::debugCheckGraphLegality(){
-    this->nodes->iterBegin();
-    AutoLODGraphNode* node;
-    while(1){
-        node = (AutoLODGraphNode*)this->nodes->iterGetNext();
-        if(!node){
-            break;
-        }
-
-        //check mutual adjacency 
-        for(int adjIndex : node->adjacentNodes){
-            AutoLODGraphNode* adjNode = (AutoLODGraphNode*)nodes->get(uuid128(adjIndex));
-            if(!adjNode){
-                std::cout << "Missing adjacent node!";
-                std::cout << "Central Node: "<<node->vertInd<<"\n";
-                std::cout << "Adjacent Node: "<<adjNode->vertInd<<"\n";
-                assert(0);
-            }
-            bool hasThisNode = false;
-            for(int n : adjNode->adjacentNodes){
-                if(n==node->vertInd)
-                    hasThisNode = true;
+void AutoLOD::AutoLODGraph::getNeighbors(int v, std::vector<int>& target){
+    int start = int(target.size());
+    for(int c = vertCorner[v]; c >= 0; c = cornerNext[c]){
+        geo::Facet& f = facets[c/3];
+        for(int i = 0; i < 3; i++){
+            int n = f.inds[i];
+            if(n == v){
+                continue;
             }
-            if(!hasThisNode){
-                std::cout << "Mutual Adjacency Violation: \n";
-                std::cout << "Central Node: "<<node->vertInd<<"\n";
-                std::cout << "Adjacent Node: "<<adjNode->vertInd<<"\n";
-                std::cout << "Central Node Neighbors:\n";
-                for(int n : node->adjacentNodes){
-                    std::cout << "["<<n <<"]"<< "\n";
-                }
-                std::cout << "Adjacent Node Neighbors:\n";
-                for(int n : adjNode->adjacentNodes){
-                    std::cout << "["<<n <<"]"<< "\n";
-                }
-                assert(0);
+            //one-rings are small so a linear search beats hashing here
+            if(std::find(target.begin()+start,target.end(),n) == target.end()){
+                target.push_back(n);
             }
         }
+    }
+}
 
-        //check that facet inds exist in adjacent node lists
-        for(geo::Facet f : node->facets){
+int AutoLOD::AutoLODGraph::getEdgeFacets(int v0, int v1, std::vector<int>& target){
+    int n = 0;
+    for(int c = vertCorner[v0]; c >= 0; c = cornerNext[c]){
+        if(facets[c/3].contains(v1)){
+            target.push_back(c/3);
+            n++;
+        }
+    }
+    return n;
+}
 
-            int err = -1;
-            if(f.inds[0] != node->vertInd){
-                if(!node->adjacentNodes.count(f.inds[0]))
-                    err = 0;
-            }
-            if(f.inds[1] != node->vertInd){
-                if(!node->adjacentNodes.count(f.inds[1]))
-                    err = 1;
-            }
-            if(f.inds[2] != node->vertInd){
-                if(!node->adjacentNodes.count(f.inds[2]))
-                    err = 2;
-            }
+void AutoLOD::AutoLODGraph::debugCheckGraphLegality(){
+    int nVerts = int(vertCorner.size());
+    std::vector<int> nCorners = std::vector<int>(facets.size(),0); //times each facet was found in a vertex list
 
-            if(err > 0){
-                std::cout << "Facet index missing from adjacency list:\n";
-                std::cout << "Facets: \n";
-                for(geo::Facet fl : node->facets){
-                    fl.print();
-                }
-                std::cout << "Offending facet:\n";
+    for(int v = 0; v < nVerts; v++){
+        if(!vertAlive[v]){
+            if(vertCorner[v] >= 0){
+                std::cout << "Removed vertex still has facets: "<<v<<"\n";
+                assert(0);
+            }
+            continue;
+        }
+        //check that every corner in the list belongs to a live facet at this vertex
+        for(int c = vertCorner[v]; c >= 0; c = cornerNext[c]){
+            geo::Facet& f = facets[c/3];
+            if(!facetAlive[c/3] || f.inds[c%3] != v){
+                std::cout << "Corner list violation:\n";
+                std::cout << "Central Node: "<<v<<"\n";
+                std::cout << "Offending facet ("<<(facetAlive[c/3] ? "alive" : "dead")<<"):\n";
                 f.print();
-                std::cout << "Central Node Neighbors:\n";
-                for(int n : node->adjacentNodes){
-                    std::cout << "["<<n <<"]"<< "\n";
-                }
                 assert(0);
             }
+            nCorners[c/3]++;
+        }
+    }
+
+    //check that every live facet is in the lists of its 3 vertices and only references live vertices
+    for(int i = 0; i < int(facets.size()); i++){
+        if(!facetAlive[i]){
+            continue;
+        }
+        geo::Facet& f = facets[i];
+        if(nCorners[i] != 3 || !vertAlive[f.inds[0]] || !vertAlive[f.inds[1]] || !vertAlive[f.inds[2]]){
+            std::cout << "Facet missing from vertex lists:\n";
+            f.print();
+            std::cout << "found in "<<nCorners[i]<<" lists\n";
+            assert(0);
         }
     }
     std::cout << "Graph in legal state\n";
 }
 
+void AutoLOD::LODCounters::add(const LODCounters& c){
+    candidatesEvaluated += c.candidatesEvaluated;
+    rejectedHorizon += c.rejectedHorizon;
+    rejectedNonManifold += c.rejectedNonManifold;
+    rejectedSharedNeighbors += c.rejectedSharedNeighbors;
+    rejectedNormalFlip += c.rejectedNormalFlip;
+    rejectedZeroArea += c.rejectedZeroArea;
+    lossFacetCount += c.lossFacetCount;
+    lossZeroArea += c.lossZeroArea;
+    lossNonFinite += c.lossNonFinite;
+    collapsesApplied += c.collapsesApplied;
+    skippedAffected += c.skippedAffected;
+    skippedConflict += c.skippedConflict;
+}
+
 bool AutoLOD::AutoLODGraph::ecolIsLegal(int v_keep, int v_remove){
-    if(horizonVerts.count(v_remove)){
-        return false;
-    }
-    AutoLODGraphNode* keepNode = (AutoLODGraphNode*)this->nodes->get(uuid128(v_keep));
-    AutoLODGraphNode* removeNode = (AutoLODGraphNode*)this->nodes->get(uuid128(v_remove));
-    geo::Edge coll_edge = geo::Edge(v_keep,v_remove); //collapsing edge
+    return checkEcol(v_keep,v_remove) == ECOL_LEGAL;
+}
 
+AutoLOD::EcolCheck AutoLOD::AutoLODGraph::checkEcol(int v_keep, int v_remove){
+    if(horizonVert[v_remove]){
+        return ECOL_HORIZON;
+    }
     //get facets to be removed - there should always be 2:
-    geo::Facet coll_facets [2]; //collapsing faces
+    int coll_facets [2] = {-1,-1}; //collapsing faces
     int temp = 0;
-    for(geo::Facet f : keepNode->facets){
-        if(f.contains(coll_edge)){
+    for(int c = vertCorner[v_keep]; c >= 0; c = cornerNext[c]){
+        geo::Facet& f = facets[c/3];
+        if(f.contains(v_remove)){
             if(temp > 1){
-
-                std::cout << "Problems detected...\n";
-                std::cout << "COLL EDGE: ";
-                coll_edge.print();
-
-                for(geo::Facet f : keepNode->facets){
-                    f.print();
-                }
-                exit(-1);
+                return ECOL_NON_MANIFOLD; //welded shells or duplicated facets share this edge
             }
-            coll_facets[temp] = f;
+            coll_facets[temp] = c/3;
             temp++;
         }
     }
 
     //check that there are exactly 2 shared neighbors
+    std::vector<int>& keepNeighbors = scratch.keepNeighbors;
+    std::vector<int>& removeNeighbors = scratch.removeNeighbors;
+    keepNeighbors.clear();
+    removeNeighbors.clear();
+    getNeighbors(v_keep,keepNeighbors);
+    getNeighbors(v_remove,removeNeighbors);
     int nShared = 0;
-    for(int neighbor : keepNode->adjacentNodes){
-        nShared+=int(removeNode->adjacentNodes.count(neighbor));
+    for(int neighbor : keepNeighbors){
+        nShared+=int(std::find(removeNeighbors.begin(),removeNeighbors.end(),neighbor) != removeNeighbors.end());
     }
     if(nShared == 2){
 
     } else {
-        return false;
+        return ECOL_SHARED_NEIGHBORS;
     }
 
     //check that triangle normals arent going to flip when vertex is replaced
 
     //check affected facets:
-    for(geo::Facet f : removeNode->facets){
+    RingBatch& batch = scratch.ring;
+    batch.clear();
+    for(int c = vertCorner[v_remove]; c >= 0; c = cornerNext[c]){
 
-        if(f == coll_facets[0] || f == coll_facets[1]){
+        if(c/3 == coll_facets[0] || c/3 == coll_facets[1]){
             continue;
         }
-
-        geo::Facet newFacet = geo::Facet(f);
+        geo::Facet newFacet = geo::Facet(facets[c/3]);
         newFacet.replace(v_remove,v_keep);
+        batch.push(c/3,newFacet);
+    }
+    batch.evaluate(*this);
+
+    for(int i = 0; i < batch.size(); i++){
+        //dont produce zero area facets
+        if(batch.area[i] == 0.0){
+            return ECOL_ZERO_AREA;
+        }
 
-        cgVec3 origNorm = geo::faceNormal(ptsCopy[f.inds[0]],ptsCopy[f.inds[1]],ptsCopy[f.inds[2]]);
-        cgVec3 newNorm = geo::faceNormal(ptsCopy[newFacet.inds[0]],ptsCopy[newFacet.inds[1]],ptsCopy[newFacet.inds[2]]);
-        if(dot(newNorm,origNorm) < 0.0){
+        int f = batch.facet[i];
+        float d = batch.nx[i]*facetNormalX[f] + batch.ny[i]*facetNormalY[f] + batch.nz[i]*facetNormalZ[f];
+        if(d < 0.0){
 
-            return false;
+            return ECOL_NORMAL_FLIP;
         }
     }
-    return true;
+    return ECOL_LEGAL;
 }
 
 float AutoLOD::AutoLODGraph::getEcolLoss(std::vector<cgVec3>& points, int thisnode, int neighborNode, float maxSinTheta){
-    AutoLODGraphNode* keepNode = (AutoLODGraphNode*)this->nodes->get(uuid128(thisnode));
-    AutoLODGraphNode* removeNode = (AutoLODGraphNode*)this->nodes->get(uuid128(neighborNode));
-
-    geo::Edge coll_edge = geo::Edge(keepNode->vertInd,neighborNode); //collapsing edge
     //get facets to be removed - there should always be 2:
-    geo::Facet coll_facets [2]; //collapsing faces
     int temp = 0;
-    for(geo::Facet f : keepNode->facets){
-        if(f.contains(coll_edge)){
-            coll_facets[temp] = f;
+    for(int c = vertCorner[thisnode]; c >= 0; c = cornerNext[c]){
+        if(facets[c/3].contains(neighborNode)){
             temp++;
         }
     }
     if(temp != 2){
         return -1.0;
     }
-    //loss from topology (flat surface = less loss)
-    cgVec3 n0 = geo::faceNormal(points[coll_facets[0].inds[0]],points[coll_facets[0].inds[1]],points[coll_facets[0].inds[2]]);
-    cgVec3 n1 = geo::faceNormal(points[coll_facets[1].inds[0]],points[coll_facets[1].inds[1]],points[coll_facets[1].inds[2]]);
-    float a0 = geo::triArea(points[coll_facets[0].inds[0]],points[coll_facets[0].inds[1]],points[coll_facets[0].inds[2]]);
-    float a1 = geo::triArea(points[coll_facets[1].inds[0]],points[coll_facets[1].inds[1]],points[coll_facets[1].inds[2]]);
-    // float ar = triAspectRatio(cgVec3 p1,cgVec3 p2,cgVec3 p3)
-    float lossTopo = cross(n0,n1).norm();//*(a0+a1);
-
-    AutoLODGraphNode* centerNode = (AutoLODGraphNode*)this->nodes->get(uuid128(thisnode));
-    AutoLODGraphNode* collapsingNode = (AutoLODGraphNode*)this->nodes->get(uuid128(neighborNode));
 
-    //collect all affected facets
-    std::unordered_set<geo::Facet,geo::Facet::HashFunctionUnordered> affectedFacets;
-    for( geo::Facet f : centerNode->facets){
-        affectedFacets.insert(f);
-    }
-    for( geo::Facet f : collapsingNode->facets){
-        affectedFacets.insert(f);
-    }
+    //the affected facets are every facet touching either node, the facets touching both are
+    //the collapsing ones so they are skipped when walking the remove node's list
     
     //calculate original aspect ratio metric:
     float topoAspectRatio_og = 1.0;
@@ -255,154 +415,846 @@ float AutoLOD::AutoLODGraph::getEcolLoss(std::vector<cgVec3>& points, int thisno
     //used to calculate a metric representing the information stored in the facet set
     //facet area weighted mean surface normal vector
 
-    for (geo::Facet f : affectedFacets){
-        cgVec3 p0 = points[f.inds[0]];
-        cgVec3 p1 = points[f.inds[1]];
-        cgVec3 p2 = points[f.inds[2]];
-        topoAspectRatio_og = std::max<float>(topoAspectRatio_og,geo::triAspectRatio(p0,p1,p2));
+    for(int pass = 0; pass < 2; pass++){
+        int v = pass == 0 ? thisnode : neighborNode;
+        for(int c = vertCorner[v]; c >= 0; c = cornerNext[c]){
+            if(pass == 1 && facets[c/3].contains(thisnode)){
+                continue;
+            }
+            topoAspectRatio_og = std::max<float>(topoAspectRatio_og,facetAspectRatio[c/3]);
+        }
     }
 
     float topoAspectRatio_new = 1.0;
     //check how much the normal directions change for the affected facets
-    float surfErrorMetric = 0.0;
     float sumArea = 0.0;
     float sumDifference = 0.0; // how similar the face normals are before and after the ecol operation
-    for (geo::Facet f : affectedFacets){
-        
-        if(f.contains(coll_edge)){
+
+    //facets of the kept node keep their shape, so their normal difference is zero
+    for(int c = vertCorner[thisnode]; c >= 0; c = cornerNext[c]){
+        if(facets[c/3].contains(neighborNode)){ //collapsing facet
             continue;
         }
-        geo::Facet newfacet = geo::Facet(f);
-        //here we are looping over the new facets
-        newfacet.replace(neighborNode,keepNode->vertInd);
-        cgVec3 p0 = points[newfacet.inds[0]];
-        cgVec3 p1 = points[newfacet.inds[1]];
-        cgVec3 p2 = points[newfacet.inds[2]];
-
-        cgVec3 p0_og = points[f.inds[0]];
-        cgVec3 p1_og = points[f.inds[1]];
-        cgVec3 p2_og = points[f.inds[2]];
-        
-        float area = geo::triArea(p0,p1,p2);
-        if(area == 0.0){ //dont produce zero area facets
+        float area = facetArea[c/3];
+        if(area == 0.0){ //degenerate input facet, checkEcol only looks at the reshaped ones
             return -2.0;
         }
         sumArea+=area;
-        topoAspectRatio_new = std::max<float>(topoAspectRatio_new,geo::triAspectRatio(p0,p1,p2));
-        cgVec3 normal_og = geo::faceNormal(p0_og,p1_og,p2_og);
-        cgVec3 normal_new = geo::faceNormal(p0,p1,p2);
+        topoAspectRatio_new = std::max<float>(topoAspectRatio_new,facetAspectRatio[c/3]);
+    }
+
+    //facets of the removed node are reshaped, evaluate them all in one sweep
+    RingBatch& batch = scratch.ring;
+    batch.clear();
+    for(int c = vertCorner[neighborNode]; c >= 0; c = cornerNext[c]){
+        if(facets[c/3].contains(thisnode)){ //collapsing facet
+            continue;
+        }
+        geo::Facet newfacet = geo::Facet(facets[c/3]);
+        newfacet.replace(neighborNode,thisnode);
+        batch.push(c/3,newfacet);
+    }
+    batch.evaluate(*this);
+
+    for(int i = 0; i < batch.size(); i++){
+        float area = batch.area[i];
+        if(area == 0.0){ //dont produce zero area facets (already ruled out by checkEcol for queued ecols)
+            return -2.0;
+        }
+        sumArea+=area;
+        topoAspectRatio_new = std::max<float>(topoAspectRatio_new,batch.aspectRatio[i]);
+        cgVec3 normal_og = getFacetNormal(batch.facet[i]);
+        cgVec3 normal_new = cgVec3(batch.nx[i],batch.ny[i],batch.nz[i]);
         float difference = cross(normal_new,normal_og).norm();
         sumDifference+=difference*area;
     }
     sumDifference/=sumArea;
     // std::cout << "sum Diff: "<<sumDifference<<"\n";
 
-    lossTopo = sumDifference*(1.0/maxSinTheta);
+    float lossTopo = sumDifference*(1.0/maxSinTheta);
     float aspectLoss = (topoAspectRatio_new/topoAspectRatio_og);
     return (aspectLoss+lossTopo);
 }
 
-void AutoLOD::AutoLODGraph::ecol(int v_keep, int v_remove){
-    AutoLODGraphNode* keepNode = (AutoLODGraphNode*)this->nodes->get(uuid128(v_keep));
-    AutoLODGraphNode* removeNode = (AutoLODGraphNode*)this->nodes->get(uuid128(v_remove));
+void AutoLOD::AutoLODGraph::computeQuadrics(){
+    quadrics = ArenaVector<geo::Quadric>(vertCorner.size(),quadrics.get_allocator());
+    for(int i = 0; i < int(facets.size()); i++){
+        if(!facetAlive[i]){
+            continue;
+        }
+        geo::Facet& f = facets[i];
+        geo::Quadric q = geo::facetQuadric(ptsCopy[f.inds[0]],ptsCopy[f.inds[1]],ptsCopy[f.inds[2]]);
+        quadrics[f.inds[0]].add(q);
+        quadrics[f.inds[1]].add(q);
+        quadrics[f.inds[2]].add(q);
+    }
+}
 
-    assert(keepNode);
-    assert(removeNode);
-    assert(keepNode->adjacentNodes.count(v_remove));
+float AutoLOD::AutoLODGraph::getQuadricLoss(int v_keep, int v_remove){
+    return float((quadrics[v_keep]+quadrics[v_remove]).error(ptsCopy[v_keep]));
+}
 
-    //collapsing edge
-    geo::Edge coll_edge = geo::Edge(v_keep,v_remove);
-    assert(!horizonEdges.count(coll_edge) );
+void AutoLOD::AutoLODGraph::getEcols(int v_remove, float maxSinTheta, LODCostMetric metric, std::vector<EcolCandidate>& target,
+                                      LODCounters* counters){
+    assert(vertAlive[v_remove]);
+
+    //horizon vertices are never removed, which also rules out collapsing horizon edges
+    if(horizonVert[v_remove]){
+        if(counters){
+            std::vector<int>& neighbors = scratch.neighbors;
+            neighbors.clear();
+            getNeighbors(v_remove,neighbors);
+            counters->candidatesEvaluated += int64_t(neighbors.size());
+            counters->rejectedHorizon += int64_t(neighbors.size());
+        }
+        return;
+    }
 
-    //get facets to be removed - there should always be 2:
-    geo::Facet coll_facets [2];
-    int temp = 0;
-    for(geo::Facet f : keepNode->facets){
-        if(f.contains(coll_edge)){
-            coll_facets[temp] = f;
-            temp++;
+    std::vector<int>& neighbors = scratch.neighbors;
+    neighbors.clear();
+    getNeighbors(v_remove,neighbors);
+    for(int v_keep : neighbors){
+        EcolCheck check = checkEcol(v_keep,v_remove);
+        if(counters){
+            counters->candidatesEvaluated++;
+            counters->rejectedHorizon += int64_t(check == ECOL_HORIZON);
+            counters->rejectedNonManifold += int64_t(check == ECOL_NON_MANIFOLD);
+            counters->rejectedSharedNeighbors += int64_t(check == ECOL_SHARED_NEIGHBORS);
+            counters->rejectedNormalFlip += int64_t(check == ECOL_NORMAL_FLIP);
+            counters->rejectedZeroArea += int64_t(check == ECOL_ZERO_AREA);
+        }
+        if(check == ECOL_LEGAL){
+            float loss;
+            if(metric == LOD_COST_QUADRIC){
+                loss = getQuadricLoss(v_keep,v_remove);
+            } else {
+                loss = getEcolLoss(ptsCopy,v_keep,v_remove,maxSinTheta);
+            }
+            //degenerate reshaped facets give inf/inf aspect ratios, a nan in the queue would break its ordering
+            if(!(loss >= 0) || !std::isfinite(loss)){
+                if(counters){
+                    counters->lossFacetCount += int64_t(loss == -1.0);
+                    counters->lossZeroArea += int64_t(loss == -2.0);
+                    counters->lossNonFinite += int64_t(!std::isfinite(loss));
+                }
+                continue;
+            }
+            target.push_back(EcolCandidate(loss,v_keep,v_remove,0)); //stamped when queued
+        }
+    }
+}
+
+void AutoLOD::AutoLODGraph::queueEcols(std::vector<int>& vertices, float maxSinTheta, LODCostMetric metric, EcolQueue& queue, int nThreads,
+                                        LODCounters* counters){
+    //each thread evaluates into its own buffer, they are merged into the queue afterwards
+    std::vector<std::vector<EcolCandidate>> buffers = std::vector<std::vector<EcolCandidate>>(nThreads);
+    std::vector<LODCounters> threadCounters = std::vector<LODCounters>(counters ? nThreads : 0);
+    par::parallelFor(int(vertices.size()),nThreads,[&](int i, int thread){
+        getEcols(vertices[i],maxSinTheta,metric,buffers[thread],counters ? &threadCounters[thread] : nullptr);
+    });
+    for(LODCounters& c : threadCounters){
+        counters->add(c);
+    }
+
+    //invalidate everything queued for these vertices
+    for(int v : vertices){
+        stamp[v]++;
+        queue.nLive -= nCandidates[v];
+        nCandidates[v] = 0;
+    }
+
+    for(std::vector<EcolCandidate>& buffer : buffers){
+        for(EcolCandidate& c : buffer){
+            c.stamp = stamp[c.v_remove];
+            queue.push(c);
+            nCandidates[c.v_remove]++;
+            queue.nLive++;
         }
     }
+}
+
+bool AutoLOD::AutoLODGraph::isStale(const EcolCandidate& c){
+    return !vertAlive[c.v_remove] || stamp[c.v_remove] != c.stamp;
+}
+
+int AutoLOD::AutoLODGraph::calcSize(){
+    int size = 0;
+    for(uint8_t alive : vertAlive){
+        size += int(alive);
+    }
+    return size;
+}
+
+void AutoLOD::AutoLODGraph::ecol(int v_keep, int v_remove){
+    ecol(v_keep,v_remove,this->affectedNodes,this->collapseLog);
+}
+
+void AutoLOD::AutoLODGraph::ecol(int v_keep, int v_remove, std::vector<int>& affectedTarget, CollapseLog* log){
+    assert(vertAlive[v_keep]);
+    assert(vertAlive[v_remove]);
+
+    //horizon vertices stay, so horizon edges never collapse
+    assert(!horizonVert[v_remove]);
+
+    //get facets to be removed - there should always be 2:
+    std::vector<int>& coll_facets = scratch.collFacets;
+    coll_facets.clear();
+    int temp = getEdgeFacets(v_keep,v_remove,coll_facets);
     assert(temp == 2);
     
     //collect affected nodes
-    std::unordered_set<int> affectedNodes;
-    for(int adjNode : keepNode->adjacentNodes){
-        affectedNodes.insert(adjNode);
+    std::vector<int>& affected = scratch.affected;
+    affected.clear();
+    getNeighbors(v_keep,affected);
+    getNeighbors(v_remove,affected);
+
+    //remove coll_facets from the lists of their vertices
+    for(int cf : coll_facets){
+        facetAlive[cf] = 0;
+        for(int i = 0; i < 3; i++){
+            int v = facets[cf].inds[i];
+            int* link = &vertCorner[v];
+            while(*link != cf*3+i){
+                link = &cornerNext[*link];
+            }
+            *link = cornerNext[cf*3+i];
+        }
+    }
+
+    if(log){
+        log->keep.push_back(v_keep);
+        log->remove.push_back(v_remove);
+        log->removedFacets.push_back(coll_facets[0]);
+        log->removedFacets.push_back(coll_facets[1]);
+    }
+
+    //for facets containing v_remove, replace v_remove with v_keep
+    //and move their corners over to v_keep's list
+    int c = vertCorner[v_remove];
+    while(c >= 0){
+        int next = cornerNext[c];
+        bool check = facets[c/3].replace(v_remove,v_keep);
+        assert(check);
+        updateFacetGeometry(c/3);
+        if(log){
+            log->rewrittenFacets.push_back(c/3);
+        }
+        cornerNext[c] = vertCorner[v_keep];
+        vertCorner[v_keep] = c;
+        c = next;
+    }
+    vertCorner[v_remove] = -1;
+    vertAlive[v_remove] = 0;
+    if(log){
+        log->rewrittenBegin.push_back(int(log->rewrittenFacets.size()));
+    }
+    if(!quadrics.empty()){
+        quadrics[v_keep].add(quadrics[v_remove]);
+    }
+
+    for(int nnode : affected){
+        if(nnode == v_remove){ //dont modify this one because it has been deleted
+            continue;
+        }
+        if(!wasAffected[nnode]){
+            wasAffected[nnode] = 1;
+            affectedTarget.push_back(nnode);
+        }
+    }
+}
+
+void AutoLOD::CollapseLog::append(const CollapseLog& log, int i, const std::vector<int>& vertexMap, const std::vector<int>& facetMap){
+    auto mapVertex = [&vertexMap](int v){return vertexMap.empty() ? v : vertexMap[v];};
+    auto mapFacet = [&facetMap](int f){return facetMap.empty() ? f : facetMap[f];};
+    keep.push_back(mapVertex(log.keep[i]));
+    remove.push_back(mapVertex(log.remove[i]));
+    removedFacets.push_back(mapFacet(log.removedFacets[2*i]));
+    removedFacets.push_back(mapFacet(log.removedFacets[2*i+1]));
+    for(int r = log.rewrittenBegin[i]; r < log.rewrittenBegin[i+1]; r++){
+        rewrittenFacets.push_back(mapFacet(log.rewrittenFacets[r]));
     }
-    for(int adjNode : removeNode->adjacentNodes){
-        affectedNodes.insert(adjNode);
+    rewrittenBegin.push_back(int(rewrittenFacets.size()));
+}
+
+void AutoLOD::CollapseLog::append(const CollapseLog& log, const std::vector<int>& vertexMap, const std::vector<int>& facetMap){
+    for(int i = 0; i < log.size(); i++){
+        append(log,i,vertexMap,facetMap);
     }
+}
+
+AutoLOD::ProgressiveMesh::ProgressiveMesh(std::vector<geo::Facet>& baseFacets, CollapseLog& log){
+    this->facets = baseFacets;
+    this->log = log;
+    facetAlive = std::vector<uint8_t>(facets.size(),1);
+    nAliveFacets = int(facets.size());
+}
 
-    affectedNodes.erase(v_remove); //dont modify this one because it will be deleted soon
+void AutoLOD::ProgressiveMesh::collapse(){
+    assert(nApplied < log.size());
+    int i = nApplied;
+    facetAlive[log.removedFacets[2*i]] = 0;
+    facetAlive[log.removedFacets[2*i+1]] = 0;
+    for(int r = log.rewrittenBegin[i]; r < log.rewrittenBegin[i+1]; r++){
+        facets[log.rewrittenFacets[r]].replace(log.remove[i],log.keep[i]);
+    }
+    nAliveFacets -= 2;
+    nApplied++;
+}
 
-    for(geo::Facet f : removeNode->facets){ //add remove node facets to keep node
-        keepNode->facets.insert(f);
-    };
+void AutoLOD::ProgressiveMesh::split(){
+    assert(nApplied > 0);
+    nApplied--;
+    int i = nApplied;
+    //a rewritten facet never contained keep before the collapse, so it is the only keep index in the facet
+    for(int r = log.rewrittenBegin[i]; r < log.rewrittenBegin[i+1]; r++){
+        facets[log.rewrittenFacets[r]].replace(log.keep[i],log.remove[i]);
+    }
+    facetAlive[log.removedFacets[2*i]] = 1;
+    facetAlive[log.removedFacets[2*i+1]] = 1;
+    nAliveFacets += 2;
+}
 
-    assert(affectedNodes.count(v_keep));
+void AutoLOD::ProgressiveMesh::setCollapseCount(int nCollapses){
+    nCollapses = std::max(0,std::min(nCollapses,log.size()));
+    while(nApplied < nCollapses){
+        collapse();
+    }
+    while(nApplied > nCollapses){
+        split();
+    }
+}
 
-    //remove coll_facets from facet list
-    //for facets containing v_remove, replace v_remove with v_keep
-    //and remove v_remove from adjacentNodes
-    //and add v_keep to adjacentNodes
-    for(int nnode : affectedNodes){
-        AutoLODGraphNode* node = (AutoLODGraphNode*)this->nodes->get(uuid128(nnode));
-        node->wasAffected = true;
-
-        assert(node);
-
-        //erase removed facets, if they exist
-        node->facets.erase(coll_facets[0]);
-        node->facets.erase(coll_facets[1]);
-       
-        //get facets containing v_remove, to replace v_remove with v_keep
-        std::vector<geo::Facet> facetsToUpdate;
-        for(geo::Facet f : node->facets){
-            if(f.contains(v_remove)){
-                facetsToUpdate.push_back(f);
+void AutoLOD::ProgressiveMesh::setTriangleCount(int nTriangles){
+    int nBase = nAliveFacets + 2*nApplied;
+    setCollapseCount((nBase-nTriangles+1)/2);
+}
+
+void AutoLOD::ProgressiveMesh::getFacets(std::vector<geo::Facet>& target){
+    for(int i = 0; i < int(facets.size()); i++){
+        if(facetAlive[i]){
+            target.push_back(facets[i]);
+        }
+    }
+}
+
+/**
+ * @brief Applies the cheapest queued ecols one at a time, skipping any that touch a node
+ * already affected during this pass. Returns the number of ecols applied.
+ * 
+ * @param graph 
+ * @param queue 
+ * @param maxEcols 
+ * @param maxLoss ecols costing more than this are left in the queue
+ * @param reachedMaxLoss set to true if the pass stopped at an ecol costing more than maxLoss
+ * @param appliedMaxLoss raised to the loss of every applied ecol
+ * @param counters if not nullptr, the skipped and applied ecols are added to it
+ * @return int 
+ */
+static int ecolSequential(AutoLOD::AutoLODGraph& graph, AutoLOD::EcolQueue& queue, int maxEcols, float maxLoss,
+                          bool& reachedMaxLoss, float& appliedMaxLoss, AutoLOD::LODCounters* counters){
+    int numEcols = 0;
+    while(!queue.empty()){
+        if(numEcols > maxEcols/2){
+            break;
+        }
+        AutoLOD::EcolCandidate ecolOp = queue.pop();
+        if(graph.isStale(ecolOp)){
+            continue;
+        }
+        if(ecolOp.loss > maxLoss){
+            //everything left in the queue costs at least as much
+            queue.push(ecolOp);
+            reachedMaxLoss = true;
+            break;
+        }
+        graph.nCandidates[ecolOp.v_remove]--;
+        queue.nLive--;
+        if(!graph.vertAlive[ecolOp.v_keep]){
+            continue;
+        }
+
+        if(graph.wasAffected[ecolOp.v_keep] || graph.wasAffected[ecolOp.v_remove]){
+            if(counters){
+                counters->skippedAffected++;
             }
+            continue;
         }
+        // std::cout << "loss: "<<ecolOp.loss<<"\n";
+        queue.nLive -= graph.nCandidates[ecolOp.v_remove]; //the rest of the remove node's ecols die with it
+        graph.ecol(ecolOp.v_keep,ecolOp.v_remove);
+        appliedMaxLoss = std::max(appliedMaxLoss,ecolOp.loss);
+        numEcols++;
+    }
+    if(counters){
+        counters->collapsesApplied += numEcols;
+    }
+    return numEcols;
+}
 
-        for(geo::Facet f : facetsToUpdate){
-            geo::Facet newFacet = geo::Facet(f.inds[0],f.inds[1],f.inds[2]);
-            bool check = newFacet.replace(v_remove,v_keep);
-            assert(check);
-            node->facets.erase(f);
-            node->facets.insert(newFacet);
+/**
+ * @brief Picks the cheapest queued ecols whose regions (v_keep, v_remove and their neighbors)
+ * dont overlap and applies them across nThreads threads. Returns the number of ecols applied.
+ * 
+ * @param graph 
+ * @param queue 
+ * @param maxEcols 
+ * @param nThreads 
+ * @param claimed per vertex, set to pass when the vertex is in the region of a picked ecol
+ * @param pass 
+ * @param maxLoss ecols costing more than this are left in the queue
+ * @param reachedMaxLoss set to true if the picking stopped at an ecol costing more than maxLoss
+ * @param appliedMaxLoss raised to the loss of every applied ecol
+ * @param counters if not nullptr, the deferred and applied ecols are added to it
+ * @return int 
+ */
+static int ecolIndependentSet(AutoLOD::AutoLODGraph& graph, AutoLOD::EcolQueue& queue, int maxEcols, int nThreads,
+                              std::vector<int>& claimed, int pass, float maxLoss, bool& reachedMaxLoss, float& appliedMaxLoss,
+                              AutoLOD::LODCounters* counters){
+    std::vector<AutoLOD::EcolCandidate> picked;
+    std::vector<AutoLOD::EcolCandidate> conflicts;
+    std::vector<int> region;
+    int numExamined = 0;
+    while(!queue.empty()){
+        //stop after the cheaper half of the candidates, like ecolSequential
+        if(numExamined > maxEcols/2){
+            break;
         }
-        
-        //remove v_remove from adjacent nodes
-        node->adjacentNodes.erase(v_remove);
-        //add v_keep to adjacent nodes
-        if(node->vertInd != v_keep){
-            node->adjacentNodes.insert(v_keep);
+        AutoLOD::EcolCandidate ecolOp = queue.pop();
+        if(graph.isStale(ecolOp)){
+            continue;
         }
+        if(ecolOp.loss > maxLoss){
+            queue.push(ecolOp);
+            reachedMaxLoss = true;
+            break;
+        }
+        graph.nCandidates[ecolOp.v_remove]--;
+        queue.nLive--;
+        if(!graph.vertAlive[ecolOp.v_keep]){
+            continue;
+        }
+        numExamined++;
+        if(claimed[ecolOp.v_keep] == pass || claimed[ecolOp.v_remove] == pass){
+            conflicts.push_back(ecolOp);
+            continue;
+        }
+
+        region.clear();
+        region.push_back(ecolOp.v_keep);
+        region.push_back(ecolOp.v_remove);
+        graph.getNeighbors(ecolOp.v_keep,region);
+        graph.getNeighbors(ecolOp.v_remove,region);
+        bool isFree = true;
+        for(int v : region){
+            if(claimed[v] == pass){
+                isFree = false;
+                break;
+            }
+        }
+        if(!isFree){
+            conflicts.push_back(ecolOp);
+            continue;
+        }
+        for(int v : region){
+            claimed[v] = pass;
+        }
+        //the rest of the remove node's ecols die with it, the node is still alive until the
+        //picked ecols are applied so they are invalidated through its stamp
+        graph.stamp[ecolOp.v_remove]++;
+        queue.nLive -= graph.nCandidates[ecolOp.v_remove];
+        graph.nCandidates[ecolOp.v_remove] = 0;
+        appliedMaxLoss = std::max(appliedMaxLoss,ecolOp.loss);
+        picked.push_back(ecolOp);
+    }
+
+    //conflicting ecols go back in the queue, unless their remove node is in a picked region
+    //in which case it gets re-evaluated after this pass anyway
+    for(AutoLOD::EcolCandidate& c : conflicts){
+        if(claimed[c.v_remove] == pass){
+            continue;
+        }
+        queue.push(c);
+        graph.nCandidates[c.v_remove]++;
+        queue.nLive++;
+    }
+    if(counters){
+        counters->skippedConflict += int64_t(conflicts.size());
+        counters->collapsesApplied += int64_t(picked.size());
     }
 
-    //add new neighbors to v_keep
-    for(int newNeighbor : removeNode->adjacentNodes){
-        if(newNeighbor != keepNode->vertInd)
-            keepNode->adjacentNodes.insert(newNeighbor);
+    std::vector<std::vector<int>> affected = std::vector<std::vector<int>>(nThreads);
+    std::vector<AutoLOD::CollapseLog> logs = std::vector<AutoLOD::CollapseLog>(graph.collapseLog ? nThreads : 0);
+    std::vector<std::vector<int>> logged = std::vector<std::vector<int>>(logs.size()); //picked index of each logged collapse
+    par::parallelFor(int(picked.size()),nThreads,[&](int i, int thread){
+        if(graph.collapseLog){
+            graph.ecol(picked[i].v_keep,picked[i].v_remove,affected[thread],&logs[thread]);
+            logged[thread].push_back(i);
+        } else {
+            graph.ecol(picked[i].v_keep,picked[i].v_remove,affected[thread],nullptr);
+        }
+    },16);
+    for(std::vector<int>& a : affected){
+        graph.affectedNodes.insert(graph.affectedNodes.end(),a.begin(),a.end());
     }
 
-    this->nodes->remove(uuid128(v_remove));
-    delete removeNode;
+    //the picked ecols dont overlap so any order replays correctly, log them in the order they were picked
+    if(graph.collapseLog){
+        std::vector<std::pair<int,int>> source = std::vector<std::pair<int,int>>(picked.size()); //thread and record of each picked ecol
+        for(int t = 0; t < int(logs.size()); t++){
+            for(int r = 0; r < int(logged[t].size()); r++){
+                source[logged[t][r]] = std::make_pair(t,r);
+            }
+        }
+        std::vector<int> identity;
+        for(std::pair<int,int>& src : source){
+            graph.collapseLog->append(logs[src.first],src.second,identity,identity);
+        }
+    }
+    return int(picked.size());
+}
+
+/**
+ * @brief Returns true and sets reason if options.cancel is set or options.deadline has passed
+ * 
+ * @param options 
+ * @param reason 
+ * @return true 
+ * @return false 
+ */
+static bool stopRequested(const AutoLOD::LODOptions& options, AutoLOD::LODStopReason& reason){
+    if(options.cancel && options.cancel->load(std::memory_order_relaxed)){
+        reason = AutoLOD::LOD_STOP_CANCELLED;
+        return true;
+    }
+    if(options.deadline != std::chrono::steady_clock::time_point::max() && std::chrono::steady_clock::now() >= options.deadline){
+        reason = AutoLOD::LOD_STOP_DEADLINE;
+        return true;
+    }
+    return false;
 }
 
-AutoLOD::AutoLODGraph::~AutoLODGraph(){
-    AutoLODGraphNode* node;
-    this->nodes->iterBegin();
+/**
+ * @brief Runs ecol passes over the graph until it has targetSizes.back() vertices or runs out of legal ecols.
+ * levelDone(level,size) is called as soon as the graph is down to targetSizes[level] vertices. With stopAtLevels
+ * the passes dont collapse past any of the levels, otherwise they keep the old behaviour of finishing the pass which
+ * crosses a level (genLODMesh, whose compression factor has always been approximate, and the tiles which are
+ * simplified further across the seams). The passes also stop once the cheapest ecol costs more than options.maxLoss.
+ * Levels which cant be reached (no legal ecols left, loss limit, deadline or cancel) are reported with the final size.
+ * Returns the resulting number of vertices.
+ * 
+ * @param graph 
+ * @param size number of vertices in the graph
+ * @param targetSizes decreasing vertex counts
+ * @param maxSinTheta 
+ * @param options 
+ * @param nThreads 
+ * @param stopAtLevels land exactly on each level instead of finishing the pass which crosses it
+ * @param verbose print the size after every pass
+ * @param levelDone can be empty, called with (level, size, highest loss of the ecols applied so far)
+ * @param stats if not nullptr, receives the time spent evaluating and applying ecols
+ * @param progress can be empty, called after every pass with (size, targetSizes.back())
+ * @param stopReason 
+ * @param appliedMaxLoss raised to the loss of every applied ecol
+ * @return int 
+ */
+static int simplifyGraph(AutoLOD::AutoLODGraph& graph, int size, const std::vector<int>& targetSizes, float maxSinTheta,
+                         const AutoLOD::LODOptions& options, int nThreads, bool stopAtLevels, bool verbose,
+                         const std::function<void(int,int,float)>& levelDone, AutoLOD::LODStats* stats,
+                         const std::function<void(int,int)>& progress, AutoLOD::LODStopReason& stopReason,
+                         float& appliedMaxLoss){
+    stopReason = AutoLOD::LOD_STOP_TARGET_REACHED;
+    if(options.costMetric == AutoLOD::LOD_COST_QUADRIC){
+        graph.computeQuadrics();
+    }
+
+    //min loss ecol operations, kept across passes and only re-evaluated around nodes touched by ecol
+    AutoLOD::EcolQueue queue;
+
+    //nodes whose queued ecols need to be re-evaluated, every node on the first pass
+    std::vector<int> dirtyNodes;
+    for(int v = 0; v < int(graph.vertAlive.size()); v++){
+        if(graph.vertAlive[v]){
+            dirtyNodes.push_back(v);
+        }
+    }
+
+    std::vector<int> claimed = std::vector<int>(graph.vertAlive.size(),-1); //pass in which each vertex was claimed by a parallel ecol
+    int pass = 0;
+    int level = 0;
+    int nLevels = int(targetSizes.size());
+
+    while(level < nLevels){
+        if(size <= targetSizes[level]){
+            if(levelDone){
+                levelDone(level,size,appliedMaxLoss);
+            }
+            level++;
+            continue;
+        }
+        if(stopRequested(options,stopReason)){
+            if(verbose){
+                std::cout << "Stopped early\n";
+            }
+            break;
+        }
+
+        AutoLOD::LODPassStats passStats;
+        AutoLOD::LODCounters* counters = stats ? &passStats.counters : nullptr;
+        std::chrono::steady_clock::time_point evalStart = startPhase(stats);
+        graph.queueEcols(dirtyNodes,maxSinTheta,options.costMetric,queue,nThreads,counters); //sort ecol ops
+        for(int v : graph.affectedNodes){
+            graph.wasAffected[v] = 0;
+        }
+        graph.affectedNodes.clear();
+
+        if(stats){
+            passStats.evalSeconds = endPhase(stats->candidateEval,evalStart);
+        }
+
+        if(queue.nLive == 0 ){
+            if(verbose){
+                std::cout << "No legal ecol operations, exiting\n";
+            }
+            if(stats){
+                //keep the evaluation which came up empty, it is usually the interesting one
+                passStats.size = size;
+                stats->counters.add(passStats.counters);
+                stats->passes.push_back(passStats);
+            }
+            stopReason = AutoLOD::LOD_STOP_NO_LEGAL_ECOLS;
+            break;
+        }
+        if(stopRequested(options,stopReason)){
+            //the evaluation is thrown away, the graph hasnt changed since the last pass
+            if(verbose){
+                std::cout << "Stopped early\n";
+            }
+            if(stats){
+                passStats.size = size;
+                stats->counters.add(passStats.counters);
+                stats->passes.push_back(passStats);
+            }
+            break;
+        }
 
-    while(1){
-        node = (AutoLODGraphNode*)this->nodes->iterGetNext();
-        if(node){
-            delete node;
+        std::chrono::steady_clock::time_point collapseStart = startPhase(stats);
+        int numEcols = 0;
+        int maxEcols = queue.nLive;
+        if(stopAtLevels){
+            //stop at the level instead of jumping past it, the passes apply up to maxEcols/2+1 ecols
+            maxEcols = std::min(maxEcols,2*(size-targetSizes[level])-1);
+        }
+        bool reachedMaxLoss = false;
+        if(options.parallelEcols){
+            numEcols = ecolIndependentSet(graph,queue,maxEcols,nThreads,claimed,pass,options.maxLoss,reachedMaxLoss,appliedMaxLoss,counters);
         } else {
+            numEcols = ecolSequential(graph,queue,maxEcols,options.maxLoss,reachedMaxLoss,appliedMaxLoss,counters);
+        }
+        size -= numEcols;
+        pass++;
+        // graph.debugCheckGraphLegality();
+        if(verbose){
+            std::cout << "size: "<<size<<"\n";
+        }
+
+        //ecols removing an affected node or one of its neighbors are out of date
+        dirtyNodes.clear();
+        for(int v : graph.affectedNodes){
+            dirtyNodes.push_back(v);
+            graph.getNeighbors(v,dirtyNodes);
+        }
+        std::sort(dirtyNodes.begin(),dirtyNodes.end());
+        dirtyNodes.erase(std::unique(dirtyNodes.begin(),dirtyNodes.end()),dirtyNodes.end());
+
+        //drop stale entries once they outnumber the live ones
+        if(queue.size() > 2*queue.nLive + 1024){
+            queue.compact([&graph](const AutoLOD::EcolCandidate& c){return graph.isStale(c);});
+        }
+        if(stats){
+            passStats.collapseSeconds = endPhase(stats->collapse,collapseStart);
+            passStats.size = size;
+            stats->counters.add(passStats.counters);
+            stats->passes.push_back(passStats);
+            stats->nPasses++;
+        }
+        if(progress){
+            progress(size,targetSizes.back());
+        }
+        if(reachedMaxLoss && numEcols == 0){
+            //nothing changed so the queue still starts above the limit
+            if(verbose){
+                std::cout << "Reached the loss limit\n";
+            }
+            stopReason = AutoLOD::LOD_STOP_MAX_LOSS;
             break;
         }
     }
-    delete nodes;
+    for(; level < nLevels; level++){
+        if(levelDone){
+            levelDone(level,size,appliedMaxLoss);
+        }
+    }
+    return size;
+}
+
+/**
+ * @brief Counts the vertices referenced by facets
+ * 
+ * @param facets 
+ * @param nPts 
+ * @return int 
+ */
+static int countVertices(std::vector<geo::Facet>& facets, int nPts){
+    std::vector<uint8_t> used = std::vector<uint8_t>(nPts,0);
+    int size = 0;
+    for(geo::Facet& f : facets){
+        for(int i = 0; i < 3; i++){
+            size += int(!used[f.inds[i]]);
+            used[f.inds[i]] = 1;
+        }
+    }
+    return size;
+}
+
+/**
+ * @brief Assigns the vertices in verts[begin,end) to nTiles cells by repeatedly splitting
+ * the points at the median along their longest axis (k-d split)
+ * 
+ * @param points 
+ * @param verts 
+ * @param begin 
+ * @param end 
+ * @param nTiles 
+ * @param firstTile id of the first cell in this range
+ * @param tile receives the cell of each vertex
+ */
+static void splitTiles(std::vector<cgVec3>& points, std::vector<int>& verts, int begin, int end,
+                       int nTiles, int firstTile, std::vector<int>& tile){
+    if(nTiles <= 1 || end-begin < 2){
+        for(int i = begin; i < end; i++){
+            tile[verts[i]] = firstTile;
+        }
+        return;
+    }
+    cgVec3 lo = points[verts[begin]];
+    cgVec3 hi = points[verts[begin]];
+    for(int i = begin; i < end; i++){
+        cgVec3& p = points[verts[i]];
+        lo = cgVec3(std::min(lo.x,p.x),std::min(lo.y,p.y),std::min(lo.z,p.z));
+        hi = cgVec3(std::max(hi.x,p.x),std::max(hi.y,p.y),std::max(hi.z,p.z));
+    }
+    cgVec3 extent = hi-lo;
+    int axis = 0;
+    if(extent.y > extent.at(axis)) axis = 1;
+    if(extent.z > extent.at(axis)) axis = 2;
+
+    //split the points in proportion to the number of cells on each side
+    int nLeft = nTiles/2;
+    int mid = begin + int((long long)(end-begin)*nLeft/nTiles);
+    std::nth_element(verts.begin()+begin,verts.begin()+mid,verts.begin()+end,[&points,axis](int a, int b){
+        return points[a].at(axis) < points[b].at(axis);
+    });
+    splitTiles(points,verts,begin,mid,nLeft,firstTile,tile);
+    splitTiles(points,verts,mid,end,nTiles-nLeft,firstTile+nLeft,tile);
+}
+
+/**
+ * @brief Splits the mesh into spatial cells and simplifies the facets inside each cell on its own thread.
+ * Facets spanning several cells are left alone, so the vertices on cell borders end up on the horizon of
+ * their cell and stay locked. target receives the simplified cells plus the untouched seam facets.
+ * 
+ * @param meshFacets 
+ * @param meshPoints 
+ * @param compressionFactor 
+ * @param maxSinTheta 
+ * @param stopAtLevels dont collapse any cell past its target (rounded up), see simplifyGraph
+ * @param options 
+ * @param nThreads 
+ * @param target 
+ * @param targetIds index in meshFacets of each facet in target
+ * @param log if not nullptr, receives the ecols of every cell (cell by cell) in mesh indices
+ * @param appliedMaxLoss raised to the loss of every ecol applied in the cells
+ */
+static void simplifyTiles(std::vector<geo::Facet>& meshFacets, std::vector<cgVec3>& meshPoints,
+                          float compressionFactor, float maxSinTheta, bool stopAtLevels, const AutoLOD::LODOptions& options,
+                          int nThreads, std::vector<geo::Facet>& target, std::vector<int>& targetIds,
+                          AutoLOD::CollapseLog* log, float& appliedMaxLoss){
+    int nPts = int(meshPoints.size());
+    int nTiles = options.nTiles;
+
+    std::vector<int> verts;
+    std::vector<uint8_t> used = std::vector<uint8_t>(nPts,0);
+    for(geo::Facet& f : meshFacets){
+        for(int i = 0; i < 3; i++){
+            if(!used[f.inds[i]]){
+                used[f.inds[i]] = 1;
+                verts.push_back(f.inds[i]);
+            }
+        }
+    }
+    std::vector<int> tile = std::vector<int>(nPts,-1);
+    splitTiles(meshPoints,verts,0,int(verts.size()),nTiles,0,tile);
+
+    //every vertex lives in exactly one cell so one table holds the local index of every vertex in its cell
+    std::vector<int> localIndex = std::vector<int>(nPts,-1);
+    std::vector<std::vector<int>> tileVerts = std::vector<std::vector<int>>(nTiles); //local to global index
+    std::sort(verts.begin(),verts.end());
+    for(int v : verts){
+        localIndex[v] = int(tileVerts[tile[v]].size());
+        tileVerts[tile[v]].push_back(v);
+    }
+
+    std::vector<std::vector<geo::Facet>> tileFacets = std::vector<std::vector<geo::Facet>>(nTiles);
+    std::vector<std::vector<int>> tileFacetIds = std::vector<std::vector<int>>(nTiles); //local to global facet index
+    for(int i = 0; i < int(meshFacets.size()); i++){
+        geo::Facet& f = meshFacets[i];
+        int t = tile[f.inds[0]];
+        if(tile[f.inds[1]] == t && tile[f.inds[2]] == t){
+            tileFacets[t].push_back(geo::Facet(localIndex[f.inds[0]],localIndex[f.inds[1]],localIndex[f.inds[2]]));
+            tileFacetIds[t].push_back(i);
+        } else {
+            target.push_back(f); //seam
+            targetIds.push_back(i);
+        }
+    }
+    std::vector<AutoLOD::CollapseLog> tileLogs = std::vector<AutoLOD::CollapseLog>(log ? nTiles : 0);
+    std::vector<std::vector<int>> resultIds = std::vector<std::vector<int>>(nTiles); //global index of each simplified facet
+    std::vector<float> tileMaxLoss = std::vector<float>(nTiles,0);
+
+    par::parallelFor(nTiles,nThreads,[&](int t, int thread){
+        std::vector<cgVec3> points = std::vector<cgVec3>(tileVerts[t].size());
+        for(int i = 0; i < int(points.size()); i++){
+            points[i] = meshPoints[tileVerts[t][i]];
+        }
+        AutoLOD::AutoLODGraph graph = AutoLOD::AutoLODGraph(tileFacets[t], points, options.useArena);
+        if(log){
+            graph.collapseLog = &tileLogs[t];
+        }
+        int size = graph.calcSize();
+        int targetSize = stopAtLevels ? int(ceilf(float(size)/float(compressionFactor))) : int(float(size)/float(compressionFactor));
+        AutoLOD::LODStopReason stopReason;
+        simplifyGraph(graph,size,{targetSize},maxSinTheta,options,1,stopAtLevels,false,nullptr,nullptr,nullptr,stopReason,tileMaxLoss[t]); //a stop is picked up again by the pass across the seams
+
+        //map the result back to global indices, reusing the input facets for the output
+        tileFacets[t].clear();
+        for(int i = 0; i < int(graph.facets.size()); i++){
+            if(graph.facetAlive[i]){
+                geo::Facet& f = graph.facets[i];
+                tileFacets[t].push_back(geo::Facet(tileVerts[t][f.inds[0]],tileVerts[t][f.inds[1]],tileVerts[t][f.inds[2]]));
+                resultIds[t].push_back(tileFacetIds[t][i]);
+            }
+        }
+    },1);
+
+    for(int t = 0; t < nTiles; t++){
+        target.insert(target.end(),tileFacets[t].begin(),tileFacets[t].end());
+        targetIds.insert(targetIds.end(),resultIds[t].begin(),resultIds[t].end());
+        appliedMaxLoss = std::max(appliedMaxLoss,tileMaxLoss[t]);
+        if(log){
+            //the cells dont share facets so their logs replay correctly one after the other
+            log->append(tileLogs[t],tileVerts[t],tileFacetIds[t]);
+        }
+    }
 }
 
 void AutoLOD::genLODMesh(std::vector<geo::Facet>& meshFacets, 
@@ -410,95 +1262,234 @@ void AutoLOD::genLODMesh(std::vector<geo::Facet>& meshFacets,
                  std::vector<geo::Facet>& targetFacets,
                  float compressionFactor, float maxSinTheta, int& actualSize )
 {
+    float achievedMaxLoss;
+    genLODMesh(meshFacets,meshPoints,targetFacets,compressionFactor,maxSinTheta,actualSize,achievedMaxLoss,LODOptions());
+}
+
+/**
+ * @brief Simplifies the mesh through each of the vertex counts in targetSizes (any order) in a single run,
+ * levels[i] receives the facets of the mesh once it was down to targetSizes[i] vertices
+ * 
+ * @param meshFacets 
+ * @param meshPoints 
+ * @param targetSizes 
+ * @param tileCompressionFactor compression factor of the finest level, used for the cells when options.nTiles > 1
+ * @param maxSinTheta 
+ * @param stopAtLevels land exactly on each level, see simplifyGraph
+ * @param options 
+ * @param levels 
+ * @param actualSizes 
+ * @param maxLosses highest loss of the ecols applied to reach each level
+ * @return AutoLOD::LODStopReason 
+ */
+static AutoLOD::LODStopReason simplifyToSizes(std::vector<geo::Facet>& meshFacets, std::vector<cgVec3>& meshPoints,
+                            std::vector<int>& targetSizes, float tileCompressionFactor, float maxSinTheta, bool stopAtLevels,
+                            const AutoLOD::LODOptions& options,
+                            std::vector<std::vector<geo::Facet>>& levels, std::vector<int>& actualSizes,
+                            std::vector<float>& maxLosses){
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    AutoLOD::LODStats* stats = options.stats;
+    if(stats){
+        *stats = AutoLOD::LODStats();
+        stats->phasePeakRSS = AutoLOD::resetPeakRSS();
+    }
+    int nThreads = par::numThreads(options.nThreads);
     if(maxSinTheta < 0.001){
         maxSinTheta = 0.001;
     }
-    std::cout << "num points: "<<meshPoints.size()<<"\n";
-    AutoLODGraph graph = AutoLODGraph(meshFacets, meshPoints);
-    std::cout << "graph size: "<<graph.nodes->calcSize()<<"\n";
-    graph.debugCheckGraphLegality();
-    
-    int size = graph.nodes->calcSize();
-    int baseSize = size;
-    int targetSize = int(float(baseSize)/float(compressionFactor));
+    if(options.verbose){
+        std::cout << "num points: "<<meshPoints.size()<<"\n";
+    }
 
-    while(size > targetSize){
+    int nLevels = int(targetSizes.size());
+    levels = std::vector<std::vector<geo::Facet>>(nLevels);
+    actualSizes = std::vector<int>(nLevels,0);
+    maxLosses = std::vector<float>(nLevels,0);
+    if(nLevels == 0){
+        return AutoLOD::LOD_STOP_TARGET_REACHED;
+    }
 
-        //find lowest loss ecol:
-        graph.nodes->iterBegin();
+    //run through the levels from finest to coarsest
+    std::vector<int> order = std::vector<int>(nLevels);
+    for(int i = 0; i < nLevels; i++){
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(),order.end(),[&targetSizes](int a, int b){return targetSizes[a] > targetSizes[b];});
+    std::vector<int> sortedSizes;
+    for(int i : order){
+        sortedSizes.push_back(targetSizes[i]);
+    }
 
-        //min loss over each possible ecol operation  {loss, v_k, v_rem} - sorted by loss
-        std::set<std::tuple<float, int, int>> lossHierarchy;
+    //cheap grid clustering first on meshes much larger than the target, the clustered mesh can't be replayed from the log
+    std::vector<geo::Facet> clusteredFacets;
+    std::vector<int> clusteredFacetIds;
+    std::vector<geo::Facet>& inputFacets = options.clusterFactor > 0 && !options.collapseLog && sortedSizes[0] > 0 ? clusteredFacets : meshFacets;
+    if(&inputFacets == &clusteredFacets){
+        std::chrono::steady_clock::time_point clusterStart = startPhase(stats);
+        int clusterSize = int(options.clusterFactor*float(sortedSizes[0]));
+        AutoLOD::clusterVertices(meshFacets,meshPoints,clusterSize,nThreads,clusteredFacets,clusteredFacetIds);
+        int clusteredSize = countVertices(clusteredFacets,int(meshPoints.size()));
+        tileCompressionFactor = float(clusteredSize)/float(sortedSizes[0]);
+        if(options.verbose){
+            std::cout << "clustered size: "<<clusteredSize<<"\n";
+        }
+        if(stats){
+            endPhase(stats->cluster,clusterStart);
+        }
+    }
 
-        while(1){ //sort ecol ops
-            AutoLODGraphNode* node = (AutoLODGraphNode*)graph.nodes->iterGetNext();
-            if(!node)
-                break;
+    //simplify each cell on its own first (down to the finest level), the rest of the passes then run across the seams
+    if(options.collapseLog){
+        *options.collapseLog = AutoLOD::CollapseLog();
+    }
+    std::vector<geo::Facet> tiledFacets;
+    std::vector<int> tiledFacetIds; //index in meshFacets of each tiled facet
+    float appliedMaxLoss = 0;
+    if(options.nTiles > 1){
+        std::chrono::steady_clock::time_point tilesStart = startPhase(stats);
+        simplifyTiles(inputFacets,meshPoints,tileCompressionFactor,maxSinTheta,stopAtLevels,options,nThreads,tiledFacets,tiledFacetIds,options.collapseLog,appliedMaxLoss);
+        if(stats){
+            endPhase(stats->tiles,tilesStart);
+        }
+    }
 
-            node->wasAffected = false;
+    std::chrono::steady_clock::time_point buildStart = startPhase(stats);
+    AutoLOD::AutoLODGraph graph = AutoLOD::AutoLODGraph(options.nTiles > 1 ? tiledFacets : inputFacets, meshPoints, options.useArena);
+    AutoLOD::CollapseLog log;
+    if(options.collapseLog){
+        graph.collapseLog = &log;
+    }
+    int size = graph.calcSize();
+    if(options.verbose){
+        std::cout << "graph size: "<<size<<"\n";
+        graph.debugCheckGraphLegality();
+    }
+    if(stats){
+        endPhase(stats->graphBuild,buildStart);
+        stats->graphBuild.seconds -= graph.horizonSeconds;
+        stats->horizon.seconds = graph.horizonSeconds;
+        stats->horizon.peakRSS = stats->graphBuild.peakRSS;
+    }
 
-            for(int adjNode : node->adjacentNodes){
-                if(graph.horizonEdges.count(geo::Edge(node->vertInd,adjNode))){
-                    continue;
-                }
-                if(graph.ecolIsLegal(node->vertInd,adjNode)){
-                    float loss = graph.getEcolLoss(graph.ptsCopy,node->vertInd,adjNode,maxSinTheta);
-                    if(loss < 0){
-                        continue;
-                    }
-                    lossHierarchy.insert(std::make_tuple(loss,node->vertInd,adjNode));
-                    
-                }
+    AutoLOD::LODStopReason stopReason;
+    simplifyGraph(graph,size,sortedSizes,maxSinTheta,options,nThreads,stopAtLevels,options.verbose,[&](int level, int levelSize, float levelMaxLoss){
+        //collect resulting facets
+        std::chrono::steady_clock::time_point collectStart = startPhase(stats);
+        std::vector<geo::Facet>& target = levels[order[level]];
+        for(int i = 0; i < int(graph.facets.size()); i++){
+            if(graph.facetAlive[i]){
+                target.push_back(graph.facets[i]);
             }
         }
-
-        if(lossHierarchy.size() == 0 ){
-            std::cout << "No legal ecol operations, exiting\n";
-            break;
+        actualSizes[order[level]] = levelSize;
+        maxLosses[order[level]] = levelMaxLoss;
+        if(stats){
+            endPhase(stats->resultCollect,collectStart);
         }
+    },stats,options.progress,stopReason,appliedMaxLoss);
 
-        int numEcols = 0;
-        int maxEcols = lossHierarchy.size();
-        for(auto ecolOp : lossHierarchy){
-            if(numEcols > maxEcols/2){
-                break;
-            }
-            AutoLODGraphNode* keepNode  = (AutoLODGraphNode*)graph.nodes->get(uuid128(std::get<1>(ecolOp)));
-            AutoLODGraphNode* RemNode  = (AutoLODGraphNode*)graph.nodes->get(uuid128(std::get<2>(ecolOp)));
-            if(keepNode==NULL || RemNode == NULL){
-                continue;
+    if(options.collapseLog){
+        std::vector<int> identity;
+        options.collapseLog->append(log,identity,tiledFacetIds); //tiledFacetIds is empty without tiles
+    }
+    if(stats){
+        stats->totalSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+        stats->peakRSS = AutoLOD::peakRSS();
+        if(stats->phasePeakRSS){
+            //the high water mark was reset at every phase, so the peak of the run is the highest of the phases
+            for(const AutoLOD::LODPhaseStats* phase : {&stats->cluster,&stats->tiles,&stats->graphBuild,&stats->candidateEval,
+                                                         &stats->collapse,&stats->resultCollect}){
+                stats->peakRSS = std::max(stats->peakRSS,phase->peakRSS);
             }
+        }
+    }
+    return stopReason;
+}
 
-            if(keepNode->wasAffected || RemNode->wasAffected){
-                continue;
-            }
-            // std::cout << "loss: "<<std::get<0>(ecolOp)<<"\n";
-            graph.ecol(std::get<1>(ecolOp),std::get<2>(ecolOp));
-            numEcols++;
+AutoLOD::LODStopReason AutoLOD::genLODMesh(std::vector<geo::Facet>& meshFacets, 
+                 std::vector<cgVec3>& meshPoints,
+                 std::vector<geo::Facet>& targetFacets,
+                 float compressionFactor, float maxSinTheta, int& actualSize, float& achievedMaxLoss,
+                 const LODOptions& options )
+{
+    if(compressionFactor <= 0){
+        compressionFactor = std::numeric_limits<float>::max(); //no vertex target, only options.maxLoss stops the collapses
+    }
+    int baseSize = countVertices(meshFacets,int(meshPoints.size()));
+    std::vector<int> targetSizes = {int(float(baseSize)/float(compressionFactor))};
+    std::vector<std::vector<geo::Facet>> levels;
+    std::vector<int> actualSizes;
+    std::vector<float> maxLosses;
+    LODStopReason stopReason = simplifyToSizes(meshFacets,meshPoints,targetSizes,compressionFactor,maxSinTheta,false,options,levels,actualSizes,maxLosses);
+
+    targetFacets.insert(targetFacets.end(),levels[0].begin(),levels[0].end());
+    actualSize = actualSizes[0];
+    achievedMaxLoss = maxLosses[0];
+    return stopReason;
+}
 
-            size--;
-        }
-        // graph.debugCheckGraphLegality();
-        std::cout << "size: "<<size<<"\n";
+void AutoLOD::genLODMeshes(std::vector<LODBatchItem>& items, float maxSinTheta, const LODOptions& options){
+    int nItems = int(items.size());
+    if(nItems == 0){
+        return;
     }
+    int nThreads = par::numThreads(options.nThreads);
+    int nWorkers = std::min(nThreads,nItems);
 
-    //finished
-    //collect resulting facets
-    std::unordered_set<geo::Facet,geo::Facet::HashFunctionUnordered> resultingFacets;
-    graph.nodes->iterBegin();
-    while(1){ //
-        AutoLODGraphNode* node = (AutoLODGraphNode*)graph.nodes->iterGetNext();
-        if(!node)
-            break;
-        
-        for(geo::Facet f : node->facets){
-            resultingFacets.insert(f);
-        }
+    //largest meshes first, so the batch doesnt end waiting on a big mesh which was started last
+    std::vector<int> order = std::vector<int>(nItems);
+    for(int i = 0; i < nItems; i++){
+        order[i] = i;
     }
+    std::stable_sort(order.begin(),order.end(),[&items](int a, int b){return items[a].facets->size() > items[b].facets->size();});
+
+    //threads left over when there are fewer meshes than threads go to evaluating the ecols of each mesh
+    LODOptions itemOptions = options;
+    itemOptions.nThreads = std::max(1,nThreads/nWorkers);
+    itemOptions.verbose = false;
+    itemOptions.progress = nullptr;
+    par::parallelFor(nItems,nWorkers,[&](int i, int thread){
+        LODBatchItem& item = items[order[i]];
+        LODOptions o = itemOptions;
+        o.stats = item.stats;
+        o.collapseLog = item.collapseLog;
+        item.result.clear();
+        item.stopReason = genLODMesh(*item.facets,*item.points,item.result,item.compressionFactor,maxSinTheta,
+                                     item.actualSize,item.achievedMaxLoss,o);
+    },1);
+}
 
-    for(geo::Facet f : resultingFacets){
-        targetFacets.push_back(f);
+AutoLOD::LODStopReason AutoLOD::genLODChain(std::vector<geo::Facet>& meshFacets, 
+                 std::vector<cgVec3>& meshPoints,
+                 std::vector<float>& compressionFactors, float maxSinTheta,
+                 std::vector<std::vector<geo::Facet>>& targetLevels, std::vector<int>& actualSizes,
+                 std::vector<float>& achievedMaxLosses, const LODOptions& options )
+{
+    int baseSize = countVertices(meshFacets,int(meshPoints.size()));
+    std::vector<int> targetSizes;
+    float finest = std::numeric_limits<float>::max();
+    for(float compressionFactor : compressionFactors){
+        targetSizes.push_back(int(float(baseSize)/float(compressionFactor)));
+        finest = std::min(finest,compressionFactor);
     }
+    return simplifyToSizes(meshFacets,meshPoints,targetSizes,finest,maxSinTheta,true,options,targetLevels,actualSizes,achievedMaxLosses);
+}
 
-    actualSize = size;
-}
\ No newline at end of file
+AutoLOD::LODStopReason AutoLOD::genLODChainTriangles(std::vector<geo::Facet>& meshFacets, 
+                 std::vector<cgVec3>& meshPoints,
+                 std::vector<int>& triangleCounts, float maxSinTheta,
+                 std::vector<std::vector<geo::Facet>>& targetLevels, std::vector<int>& actualSizes,
+                 std::vector<float>& achievedMaxLosses, const LODOptions& options )
+{
+    //every ecol removes exactly one vertex and two facets
+    int baseSize = countVertices(meshFacets,int(meshPoints.size()));
+    int nFacets = int(meshFacets.size());
+    std::vector<int> targetSizes;
+    int finest = 1;
+    for(int triangleCount : triangleCounts){
+        int nEcols = std::max(0,(nFacets-triangleCount+1)/2);
+        targetSizes.push_back(baseSize-nEcols);
+        finest = std::max(finest,baseSize-nEcols);
+    }
+    return simplifyToSizes(meshFacets,meshPoints,targetSizes,float(baseSize)/float(finest),maxSinTheta,true,options,targetLevels,actualSizes,achievedMaxLosses);
+}
@@ -1,5 +1,8 @@
 #include "Geometry.hpp"
 #include <functional>
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
 
 //COMMON
 uint64_t geo::hash(uint64_t value){
@@ -106,6 +109,139 @@ float geo::triAspectRatio(cgVec3 p1,cgVec3 p2,cgVec3 p3){
     return a*b*c/(8*(s-a)*(s-b)*(s-c));
 }
 
+//same operations in the same order as triArea, triAspectRatio and faceNormal. This file is built with
+//-ffp-contract=off (see the makefiles), fused multiply adds would round the scalar tail of triMetricsBatch
+//differently from its vector body and a triangle's metrics would depend on its position in the batch
+static inline void triMetrics(const float* x, const float* y, const float* z, int i0, int i1, int i2,
+                              float& area, float& aspectRatio, float& nx, float& ny, float& nz){
+    float e1x = x[i1]-x[i0], e1y = y[i1]-y[i0], e1z = z[i1]-z[i0];
+    float e2x = x[i2]-x[i0], e2y = y[i2]-y[i0], e2z = z[i2]-z[i0];
+    float cx = e1y*e2z - e1z*e2y;
+    float cy = e1z*e2x - e1x*e2z;
+    float cz = e1x*e2y - e1y*e2x;
+    float len = sqrtf(cx*cx + cy*cy + cz*cz);
+    area = 0.5f*len;
+    nx = cx/len;
+    ny = cy/len;
+    nz = cz/len;
+
+    float dx = x[i0]-x[i1], dy = y[i0]-y[i1], dz = z[i0]-z[i1];
+    float a = sqrtf(dx*dx + dy*dy + dz*dz);
+    dx = x[i1]-x[i2]; dy = y[i1]-y[i2]; dz = z[i1]-z[i2];
+    float b = sqrtf(dx*dx + dy*dy + dz*dz);
+    dx = x[i2]-x[i0]; dy = y[i2]-y[i0]; dz = z[i2]-z[i0];
+    float c = sqrtf(dx*dx + dy*dy + dz*dz);
+    float s = (a+b+c)/2;
+    aspectRatio = a*b*c/(8*(s-a)*(s-b)*(s-c));
+}
+
+void geo::triMetricsBatch(const float* x, const float* y, const float* z,
+                          const int* i0, const int* i1, const int* i2, int n,
+                          float* area, float* aspectRatio, float* nx, float* ny, float* nz){
+    int t = 0;
+#if defined(__AVX512F__)
+    const __m512 half16 = _mm512_set1_ps(0.5f);
+    const __m512 eight16 = _mm512_set1_ps(8.0f);
+    for(; t+16 <= n; t+=16){
+        __m512i a0 = _mm512_loadu_si512((const void*)(i0+t));
+        __m512i a1 = _mm512_loadu_si512((const void*)(i1+t));
+        __m512i a2 = _mm512_loadu_si512((const void*)(i2+t));
+        __m512 x0 = _mm512_i32gather_ps(a0,x,4), y0 = _mm512_i32gather_ps(a0,y,4), z0 = _mm512_i32gather_ps(a0,z,4);
+        __m512 x1 = _mm512_i32gather_ps(a1,x,4), y1 = _mm512_i32gather_ps(a1,y,4), z1 = _mm512_i32gather_ps(a1,z,4);
+        __m512 x2 = _mm512_i32gather_ps(a2,x,4), y2 = _mm512_i32gather_ps(a2,y,4), z2 = _mm512_i32gather_ps(a2,z,4);
+
+        __m512 e1x = _mm512_sub_ps(x1,x0), e1y = _mm512_sub_ps(y1,y0), e1z = _mm512_sub_ps(z1,z0);
+        __m512 e2x = _mm512_sub_ps(x2,x0), e2y = _mm512_sub_ps(y2,y0), e2z = _mm512_sub_ps(z2,z0);
+        __m512 cx = _mm512_sub_ps(_mm512_mul_ps(e1y,e2z),_mm512_mul_ps(e1z,e2y));
+        __m512 cy = _mm512_sub_ps(_mm512_mul_ps(e1z,e2x),_mm512_mul_ps(e1x,e2z));
+        __m512 cz = _mm512_sub_ps(_mm512_mul_ps(e1x,e2y),_mm512_mul_ps(e1y,e2x));
+        __m512 len = _mm512_sqrt_ps(_mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(cx,cx),_mm512_mul_ps(cy,cy)),_mm512_mul_ps(cz,cz)));
+        _mm512_storeu_ps(area+t,_mm512_mul_ps(half16,len));
+        _mm512_storeu_ps(nx+t,_mm512_div_ps(cx,len));
+        _mm512_storeu_ps(ny+t,_mm512_div_ps(cy,len));
+        _mm512_storeu_ps(nz+t,_mm512_div_ps(cz,len));
+
+        __m512 dx = _mm512_sub_ps(x0,x1), dy = _mm512_sub_ps(y0,y1), dz = _mm512_sub_ps(z0,z1);
+        __m512 a = _mm512_sqrt_ps(_mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(dx,dx),_mm512_mul_ps(dy,dy)),_mm512_mul_ps(dz,dz)));
+        dx = _mm512_sub_ps(x1,x2); dy = _mm512_sub_ps(y1,y2); dz = _mm512_sub_ps(z1,z2);
+        __m512 b = _mm512_sqrt_ps(_mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(dx,dx),_mm512_mul_ps(dy,dy)),_mm512_mul_ps(dz,dz)));
+        dx = _mm512_sub_ps(x2,x0); dy = _mm512_sub_ps(y2,y0); dz = _mm512_sub_ps(z2,z0);
+        __m512 c = _mm512_sqrt_ps(_mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(dx,dx),_mm512_mul_ps(dy,dy)),_mm512_mul_ps(dz,dz)));
+        __m512 s = _mm512_mul_ps(_mm512_add_ps(_mm512_add_ps(a,b),c),half16);
+        __m512 num = _mm512_mul_ps(_mm512_mul_ps(a,b),c);
+        __m512 den = _mm512_mul_ps(_mm512_mul_ps(_mm512_mul_ps(eight16,_mm512_sub_ps(s,a)),_mm512_sub_ps(s,b)),_mm512_sub_ps(s,c));
+        _mm512_storeu_ps(aspectRatio+t,_mm512_div_ps(num,den));
+    }
+#endif
+#if defined(__AVX2__)
+    const __m256 half8 = _mm256_set1_ps(0.5f);
+    const __m256 eight8 = _mm256_set1_ps(8.0f);
+    for(; t+8 <= n; t+=8){
+        __m256i a0 = _mm256_loadu_si256((const __m256i*)(i0+t));
+        __m256i a1 = _mm256_loadu_si256((const __m256i*)(i1+t));
+        __m256i a2 = _mm256_loadu_si256((const __m256i*)(i2+t));
+        __m256 x0 = _mm256_i32gather_ps(x,a0,4), y0 = _mm256_i32gather_ps(y,a0,4), z0 = _mm256_i32gather_ps(z,a0,4);
+        __m256 x1 = _mm256_i32gather_ps(x,a1,4), y1 = _mm256_i32gather_ps(y,a1,4), z1 = _mm256_i32gather_ps(z,a1,4);
+        __m256 x2 = _mm256_i32gather_ps(x,a2,4), y2 = _mm256_i32gather_ps(y,a2,4), z2 = _mm256_i32gather_ps(z,a2,4);
+
+        __m256 e1x = _mm256_sub_ps(x1,x0), e1y = _mm256_sub_ps(y1,y0), e1z = _mm256_sub_ps(z1,z0);
+        __m256 e2x = _mm256_sub_ps(x2,x0), e2y = _mm256_sub_ps(y2,y0), e2z = _mm256_sub_ps(z2,z0);
+        __m256 cx = _mm256_sub_ps(_mm256_mul_ps(e1y,e2z),_mm256_mul_ps(e1z,e2y));
+        __m256 cy = _mm256_sub_ps(_mm256_mul_ps(e1z,e2x),_mm256_mul_ps(e1x,e2z));
+        __m256 cz = _mm256_sub_ps(_mm256_mul_ps(e1x,e2y),_mm256_mul_ps(e1y,e2x));
+        __m256 len = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(cx,cx),_mm256_mul_ps(cy,cy)),_mm256_mul_ps(cz,cz)));
+        _mm256_storeu_ps(area+t,_mm256_mul_ps(half8,len));
+        _mm256_storeu_ps(nx+t,_mm256_div_ps(cx,len));
+        _mm256_storeu_ps(ny+t,_mm256_div_ps(cy,len));
+        _mm256_storeu_ps(nz+t,_mm256_div_ps(cz,len));
+
+        __m256 dx = _mm256_sub_ps(x0,x1), dy = _mm256_sub_ps(y0,y1), dz = _mm256_sub_ps(z0,z1);
+        __m256 a = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx,dx),_mm256_mul_ps(dy,dy)),_mm256_mul_ps(dz,dz)));
+        dx = _mm256_sub_ps(x1,x2); dy = _mm256_sub_ps(y1,y2); dz = _mm256_sub_ps(z1,z2);
+        __m256 b = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx,dx),_mm256_mul_ps(dy,dy)),_mm256_mul_ps(dz,dz)));
+        dx = _mm256_sub_ps(x2,x0); dy = _mm256_sub_ps(y2,y0); dz = _mm256_sub_ps(z2,z0);
+        __m256 c = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx,dx),_mm256_mul_ps(dy,dy)),_mm256_mul_ps(dz,dz)));
+        __m256 s = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(a,b),c),half8);
+        __m256 num = _mm256_mul_ps(_mm256_mul_ps(a,b),c);
+        __m256 den = _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(eight8,_mm256_sub_ps(s,a)),_mm256_sub_ps(s,b)),_mm256_sub_ps(s,c));
+        _mm256_storeu_ps(aspectRatio+t,_mm256_div_ps(num,den));
+    }
+#endif
+    for(; t < n; t++){
+        triMetrics(x,y,z,i0[t],i1[t],i2[t],area[t],aspectRatio[t],nx[t],ny[t],nz[t]);
+    }
+}
+
+geo::Quadric::Quadric(cgVec3 n, cgVec3 p, double weight){
+    double a = n.x;
+    double b = n.y;
+    double c = n.z;
+    double d = -(a*p.x + b*p.y + c*p.z);
+    q[0] = weight*a*a; q[1] = weight*a*b; q[2] = weight*a*c; q[3] = weight*a*d;
+    q[4] = weight*b*b; q[5] = weight*b*c; q[6] = weight*b*d;
+    q[7] = weight*c*c; q[8] = weight*c*d;
+    q[9] = weight*d*d;
+}
+
+double geo::Quadric::error(const cgVec3& p) const {
+    double x = p.x;
+    double y = p.y;
+    double z = p.z;
+    return q[0]*x*x + 2*q[1]*x*y + 2*q[2]*x*z + 2*q[3]*x
+                    +   q[4]*y*y + 2*q[5]*y*z + 2*q[6]*y
+                                 +   q[7]*z*z + 2*q[8]*z
+                                              +   q[9];
+}
+
+geo::Quadric geo::facetQuadric(cgVec3& p1,cgVec3& p2,cgVec3& p3){
+    cgVec3 c = cross(p2-p1,p3-p1);
+    float n = c.norm();
+    if(n == 0.0){ //degenerate facet has no plane
+        return Quadric();
+    }
+    return Quadric(c/n,p1,0.5*n);
+}
+
 bool geo::Facet::operator == (const geo::Facet& f1) const {
     return 
     (inds[0] == f1.inds[0] || inds[0] == f1.inds[1] || inds[0] == f1.inds[2]) && //contains ind1
@@ -142,11 +278,11 @@ bool geo::Facet::sharesEdge(Facet& f2){
 }
 
 void geo::remapVertices(std::vector<geo::Facet>& og_facets, std::vector<cgVec3>& og_vertices, std::vector<geo::Facet>& new_facets, std::vector<cgVec3>& new_vertices){
-    std::unordered_map<int, int> indMap; 
+    std::vector<int> indMap = std::vector<int>(og_vertices.size(),-1); //-1 until the vertex is used
     
     for(geo::Facet f : og_facets){
         for(int i = 0; i < 3; i++){
-            if(indMap.count(f.inds[i])){
+            if(indMap[f.inds[i]] >= 0){
                 continue; //already mapped this one
             } else {
                 indMap[f.inds[i]] = int(new_vertices.size());
@@ -162,4 +298,19 @@ void geo::remapVertices(std::vector<geo::Facet>& og_facets, std::vector<cgVec3>&
         new_facets[i] = geo::Facet(i0,i1,i2);
 
     }
-}
\ No newline at end of file
+}
+
+void geo::vertexNormals(std::vector<geo::Facet>& facets, std::vector<cgVec3>& vertices, std::vector<cgVec3>& normals){
+    normals = std::vector<cgVec3>(vertices.size(),cgVec3(0,0,0));
+    for(geo::Facet& f : facets){
+        cgVec3 normal = faceNormal(vertices[f.inds[0]],vertices[f.inds[1]],vertices[f.inds[2]]);
+        for(int i = 0; i < 3; i++){
+            normals[f.inds[i]] = normals[f.inds[i]]+normal;
+        }
+    }
+    for(cgVec3& n : normals){
+        if(n.x != 0 || n.y != 0 || n.z != 0){
+            n.normalize();
+        }
+    }
+}
@@ -0,0 +1,121 @@
+#include "HashTable.hpp"
+
+//HashTable
+
+HashTable::HashTable(int log2Bins) : table(log2Bins) {
+}
+
+HashTable::~HashTable(){
+}
+
+void HashTable::add(void* value, uint64_t lookupValue){
+    table.add(value,lookupValue);
+}
+
+void* HashTable::get(uint64_t lookupValue){
+    void** value = table.getPtr(lookupValue);
+    return value ? *value : NULL;
+}
+
+void HashTable::remove(uint64_t lookupValue){
+    void* value;
+    if(!table.pop(lookupValue,value)){
+        std::cout << "ERROR: object missing from hash table...\n";
+        assert(false);
+    }
+}
+
+void* HashTable::pop(uint64_t lookupValue){
+    void* value = NULL;
+    table.pop(lookupValue,value);
+    return value;
+}
+
+uint32_t HashTable::hash(uint64_t value){
+    return uint32_t(HashKey64()(value));
+}
+
+int HashTable::calcSize(){
+    return table.getSize();
+}
+
+void HashTable::clear(){
+    table.clear();
+}
+
+void HashTable::iterBegin(){
+    iterInd = 0;
+    table.holdElements(true);
+}
+
+void* HashTable::iterGetNext(){
+    while(iterInd < table.numElements()){
+        FlatHashTable<uint64_t,void*,HashKey64>::element& e = table.getElement(iterInd);
+        iterInd++;
+        if(e.alive){
+            return e.value;
+        }
+    }
+    table.holdElements(false);
+    return NULL;
+}
+
+//HashTable128
+
+HashTable128::HashTable128(int log2Bins) : table(log2Bins) {
+}
+
+HashTable128::~HashTable128(){
+}
+
+void HashTable128::add(void* value, uuid128 lookupValue){
+    table.add(value,lookupValue);
+}
+
+void* HashTable128::get(uuid128 lookupValue){
+    void** value = table.getPtr(lookupValue);
+    return value ? *value : NULL;
+}
+
+void HashTable128::remove(uuid128 lookupValue){
+    void* value;
+    if(!table.pop(lookupValue,value)){
+        std::cout << "ERROR: object missing from hash table...\n";
+        assert(false);
+    }
+}
+
+void* HashTable128::pop(uuid128 lookupValue){
+    void* value = NULL;
+    table.pop(lookupValue,value);
+    return value;
+}
+
+uint32_t HashTable128::hash(uuid128 value){
+    return uint32_t(HashKey128()(value));
+}
+
+int HashTable128::calcSize(){
+    return table.getSize();
+}
+
+void HashTable128::clear(){
+    table.clear();
+}
+
+void HashTable128::iterBegin(){
+    iterInd = 0;
+    table.holdElements(true);
+}
+
+void* HashTable128::iterGetNext(){
+    while(iterInd < table.numElements()){
+        FlatHashTable<uuid128,void*,HashKey128>::element& e = table.getElement(iterInd);
+        iterInd++;
+        if(e.alive){
+            return e.value;
+        }
+    }
+    table.holdElements(false);
+    return NULL;
+}
@@ -0,0 +1,73 @@
+#include "MappedFile.hpp"
+#include <stdio.h>
+#ifndef _WIN64
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile(){
+    close();
+}
+
+bool MappedFile::open(const std::string& filename){
+    close();
+#ifdef _WIN64
+    FILE* file = fopen(filename.c_str(),"rb");
+    if(!file){
+        return false;
+    }
+    _fseeki64(file,0,SEEK_END);
+    long long size = _ftelli64(file);
+    _fseeki64(file,0,SEEK_SET);
+    buffer.resize(size_t(size));
+    bool ok = size >= 0 && fread(buffer.data(),1,buffer.size(),file) == buffer.size();
+    fclose(file);
+    if(!ok){
+        buffer.clear();
+        return false;
+    }
+    bytes = buffer.data();
+    nBytes = buffer.size();
+    return true;
+#else
+    int fd = ::open(filename.c_str(),O_RDONLY);
+    if(fd < 0){
+        return false;
+    }
+    struct stat st;
+    if(fstat(fd,&st) != 0){
+        ::close(fd);
+        return false;
+    }
+    nBytes = size_t(st.st_size);
+    if(nBytes == 0){ //mmap refuses empty mappings, an empty file is still a valid (empty) view
+        ::close(fd);
+        return true;
+    }
+    void* p = mmap(nullptr,nBytes,PROT_READ,MAP_PRIVATE,fd,0);
+    ::close(fd); //the mapping keeps its own reference to the file
+    if(p == MAP_FAILED){
+        nBytes = 0;
+        return false;
+    }
+    madvise(p,nBytes,MADV_SEQUENTIAL);
+    bytes = (const char*)p;
+    mapped = true;
+    return true;
+#endif
+}
+
+void MappedFile::close(){
+#ifndef _WIN64
+    if(mapped){
+        munmap((void*)bytes,nBytes);
+    }
+#endif
+    buffer.clear();
+    buffer.shrink_to_fit();
+    bytes = nullptr;
+    nBytes = 0;
+    mapped = false;
+}
@@ -0,0 +1,208 @@
+#include "MeshCache.hpp"
+#include <stdio.h>
+#include <string.h>
+
+static_assert(sizeof(cgVec3) == 12 && sizeof(cgVec2) == 8, "mesh cache arrays are stored as packed floats");
+static_assert(sizeof(MeshCacheHeader) == 48 && sizeof(MeshCacheRecord) == 14*8, "mesh cache structs must not be padded");
+
+static const uint32_t byteOrderMark = 0x01020304;
+
+static uint64_t alignUp(uint64_t offset){
+    return (offset + 15) & ~uint64_t(15);
+}
+
+/**
+ * @brief Checks that count elements of elementSize bytes at offset lie inside a file of fileSize bytes
+ *
+ */
+static bool inFile(uint64_t offset, uint64_t count, uint64_t elementSize, uint64_t fileSize){
+    if(offset > fileSize || count > (fileSize - offset)/elementSize){
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Checks that the indices of an object make whole facets and only reference its vertices, a stale or
+ * corrupt cache would otherwise hand out of range indices to the simplifier
+ *
+ */
+static bool validIndices(const int* indices, uint64_t nIndices, uint64_t nVertices){
+    if(nIndices % 3 != 0){
+        return false;
+    }
+    for(uint64_t i = 0; i < nIndices; i++){
+        if(indices[i] < 0 || uint64_t(indices[i]) >= nVertices){
+            return false;
+        }
+    }
+    return true;
+}
+
+bool MeshCache::open(const std::string& filename){
+    close();
+    if(!file.open(filename)){
+        return false;
+    }
+    const char* data = file.data();
+    uint64_t size = file.size();
+    MeshCacheHeader header;
+    if(size < sizeof(header)){
+        close();
+        return false;
+    }
+    memcpy(&header,data,sizeof(header));
+    if(memcmp(header.magic,MESH_CACHE_MAGIC,8) != 0 || header.version != MESH_CACHE_VERSION ||
+       header.byteOrder != byteOrderMark || header.fileSize != size ||
+       !inFile(sizeof(header),header.nObjects,sizeof(MeshCacheRecord),size)){
+        close();
+        return false;
+    }
+    srcSize = header.sourceSize;
+    srcTime = header.sourceTime;
+
+    objects.resize(header.nObjects);
+    for(uint32_t i = 0; i < header.nObjects; i++){
+        MeshCacheRecord record;
+        memcpy(&record,data+sizeof(header)+i*sizeof(MeshCacheRecord),sizeof(record));
+        bool valid = record.nVertices < uint64_t(1) << 31 && record.nIndices < uint64_t(1) << 31 &&
+                     inFile(record.positions,record.nVertices,sizeof(cgVec3),size) &&
+                     inFile(record.normals,record.nVertices,sizeof(cgVec3),size) &&
+                     inFile(record.textCoords,record.nVertices,sizeof(cgVec2),size) &&
+                     inFile(record.indices,record.nIndices,sizeof(int),size) &&
+                     inFile(record.name,record.nameLength,1,size) &&
+                     inFile(record.matName,record.matNameLength,1,size) &&
+                     inFile(record.mtllib,record.mtllibLength,1,size) &&
+                     inFile(record.filename,record.filenameLength,1,size) &&
+                     validIndices((const int*)(data+record.indices),record.nIndices,record.nVertices);
+        if(!valid){
+            close();
+            return false;
+        }
+        MeshCacheObject& object = objects[i];
+        object.name = std::string(data+record.name,record.nameLength);
+        object.matName = std::string(data+record.matName,record.matNameLength);
+        object.mtllib = std::string(data+record.mtllib,record.mtllibLength);
+        object.filename = std::string(data+record.filename,record.filenameLength);
+        object.positions = (const cgVec3*)(data+record.positions);
+        object.normals = (const cgVec3*)(data+record.normals);
+        object.textCoords = (const cgVec2*)(data+record.textCoords);
+        object.nVertices = int(record.nVertices);
+        object.indices = (const int*)(data+record.indices);
+        object.nIndices = int(record.nIndices);
+    }
+    return true;
+}
+
+void MeshCache::close(){
+    file.close();
+    objects.clear();
+    srcSize = 0;
+    srcTime = 0;
+}
+
+/**
+ * @brief Writes size bytes followed by zeros up to the next 16 byte boundary
+ *
+ */
+static void writePadded(FILE* out, const void* data, uint64_t size){
+    static const char zeros[16] = {0};
+    if(size > 0){
+        fwrite(data,1,size,out);
+    }
+    fwrite(zeros,1,alignUp(size)-size,out);
+}
+
+bool writeMeshCache(const std::string& filename, std::vector<objItem*>& items, uint64_t sourceSize, int64_t sourceTime){
+    //lay the file out first so the header and records can be written in one go
+    MeshCacheHeader header;
+    memset(&header,0,sizeof(header));
+    memcpy(header.magic,MESH_CACHE_MAGIC,8);
+    header.version = MESH_CACHE_VERSION;
+    header.byteOrder = byteOrderMark;
+    header.nObjects = uint32_t(items.size());
+    header.sourceSize = sourceSize;
+    header.sourceTime = sourceTime;
+
+    std::vector<MeshCacheRecord> records = std::vector<MeshCacheRecord>(items.size());
+    uint64_t offset = alignUp(sizeof(header) + records.size()*sizeof(MeshCacheRecord));
+    for(size_t i = 0; i < items.size(); i++){
+        objItem* item = items[i];
+        MeshCacheRecord& record = records[i];
+        //loaded objItems have one normal and texture coordinate per position, anything else cant be stored
+        if(item->normals.size() != item->positions.size() || item->textCoords.size() != item->positions.size()){
+            return false;
+        }
+        record.nVertices = item->positions.size();
+        record.nIndices = item->indices.size();
+        record.positions = offset;     offset = alignUp(offset + record.nVertices*sizeof(cgVec3));
+        record.normals = offset;       offset = alignUp(offset + record.nVertices*sizeof(cgVec3));
+        record.textCoords = offset;    offset = alignUp(offset + record.nVertices*sizeof(cgVec2));
+        record.indices = offset;       offset = alignUp(offset + record.nIndices*sizeof(int));
+        record.name = offset;          record.nameLength = item->name.size();          offset = alignUp(offset + record.nameLength);
+        record.matName = offset;       record.matNameLength = item->matName.size();    offset = alignUp(offset + record.matNameLength);
+        record.mtllib = offset;        record.mtllibLength = item->mtllib.size();      offset = alignUp(offset + record.mtllibLength);
+        record.filename = offset;      record.filenameLength = item->filename.size();  offset = alignUp(offset + record.filenameLength);
+    }
+    header.fileSize = offset;
+
+    std::string tempName = filename + ".tmp";
+    FILE* out = fopen(tempName.c_str(),"wb");
+    if(!out){
+        return false;
+    }
+    fwrite(&header,1,sizeof(header),out);
+    writePadded(out,records.data(),records.size()*sizeof(MeshCacheRecord));
+    for(size_t i = 0; i < items.size(); i++){
+        objItem* item = items[i];
+        MeshCacheRecord& record = records[i];
+        writePadded(out,item->positions.data(),record.nVertices*sizeof(cgVec3));
+        writePadded(out,item->normals.data(),record.nVertices*sizeof(cgVec3));
+        writePadded(out,item->textCoords.data(),record.nVertices*sizeof(cgVec2));
+        writePadded(out,item->indices.data(),record.nIndices*sizeof(int));
+        writePadded(out,item->name.data(),record.nameLength);
+        writePadded(out,item->matName.data(),record.matNameLength);
+        writePadded(out,item->mtllib.data(),record.mtllibLength);
+        writePadded(out,item->filename.data(),record.filenameLength);
+    }
+    bool ok = !ferror(out);
+    ok = fclose(out) == 0 && ok;
+    if(ok){
+#ifdef _WIN64
+        remove(filename.c_str()); //rename doesnt replace an existing file on windows
+#endif
+        ok = rename(tempName.c_str(),filename.c_str()) == 0;
+    }
+    if(!ok){
+        remove(tempName.c_str());
+    }
+    return ok;
+}
+
+void MeshCache::load(std::vector<objItem*>& target){
+    for(const MeshCacheObject& object : objects){
+        objItem* item = new objItem();
+        item->name = object.name;
+        item->matName = object.matName;
+        item->mtllib = object.mtllib;
+        item->filename = object.filename;
+        item->positions.assign(object.positions,object.positions+object.nVertices);
+        item->normals.assign(object.normals,object.normals+object.nVertices);
+        item->textCoords.assign(object.textCoords,object.textCoords+object.nVertices);
+        item->indices.assign(object.indices,object.indices+object.nIndices);
+        target.push_back(item);
+    }
+}
+
+bool loadMeshCache(const std::string& filename, std::vector<objItem*>& target){
+    MeshCache cache;
+    if(!cache.open(filename)){
+        return false;
+    }
+    cache.load(target);
+    return true;
+}
+
+std::string meshCachePath(const std::string& filename){
+    return filename + MESH_CACHE_EXTENSION;
+}
@@ -1,5 +1,211 @@
 #include "MeshLoader.hpp"
-#include "Sets.hpp"
+#include "HashTable.hpp"
+#include "MappedFile.hpp"
+#include "MeshCache.hpp"
+#include "Parallel.hpp"
+#include "Geometry.hpp"
+#include <string.h>
+#include <ctype.h>
+#include <stdlib.h>
+#include <math.h>
+#include <stdint.h>
+#include <algorithm>
+#include <memory>
+#include <filesystem>
+
+/**
+ * @brief Packs the (position, texture coordinate, normal) indices of a facet corner into one lookup value
+ *
+ */
+static inline uuid128 cornerKey(int position, int textCoord, int normal){
+    uuid128 key;
+    key.dat[0] = uint64_t(uint32_t(position)) | (uint64_t(uint32_t(textCoord)) << 32);
+    key.dat[1] = uint32_t(normal);
+    return key;
+}
+
+/**
+ * @brief Numbers the distinct (position, texture coordinate, normal) triples of the facet corners in the order
+ * they first appear, so the result doesnt depend on the thread count.
+ * Small objects use one hash table. Large ones are split into buckets by the hash of the triple (keeping the corners
+ * of a bucket in file order), the first corner of every triple is found bucket by bucket on nThreads threads,
+ * and the vertices are then numbered with a prefix sum over the corners.
+ *
+ * @param vertexPosIndices
+ * @param textPosIndices
+ * @param normalIndices
+ * @param nThreads
+ * @param cornerVertex receives the vertex of every corner
+ * @param vertexCorner receives the first corner of every vertex
+ */
+static void dedupeCorners(std::vector<int>& vertexPosIndices, std::vector<int>& textPosIndices, std::vector<int>& normalIndices,
+                          int nThreads, std::vector<int>& cornerVertex, std::vector<int>& vertexCorner){
+    int n = int(vertexPosIndices.size());
+    cornerVertex.resize(n);
+    vertexCorner.clear();
+    auto key = [&](int c){return cornerKey(vertexPosIndices[c],textPosIndices[c],normalIndices[c]);};
+
+    const int minParallelCorners = 1 << 16;
+    if(nThreads <= 1 || n < minParallelCorners){
+        FlatHashTable<uuid128,int,HashKey128> table = FlatHashTable<uuid128,int,HashKey128>(int(log2(double(n)+1))+1);
+        for(int c = 0; c < n; c++){
+            uuid128 k = key(c);
+            int v = table.find(k); //element indices are the vertices, in the order they were added
+            if(v < 0){
+                v = table.numElements();
+                table.add(v,k);
+                vertexCorner.push_back(c);
+            }
+            cornerVertex[c] = v;
+        }
+        return;
+    }
+
+    //corners are handled in nRanges contiguous ranges, so every step keeps them in file order
+    int nRanges = nThreads;
+    int bucketBits = 1;
+    while((1 << bucketBits) < nThreads*8){
+        bucketBits++;
+    }
+    int nBuckets = 1 << bucketBits;
+    auto rangeBegin = [n,nRanges](int r){return int(int64_t(n)*r/nRanges);};
+
+    //count the corners of every bucket in every range, then scatter them so each bucket is contiguous
+    std::vector<int> cornerBucket = std::vector<int>(n);
+    std::vector<int> offsets = std::vector<int>(size_t(nRanges)*nBuckets,0); //[range][bucket]
+    par::parallelFor(nRanges,nThreads,[&](int r, int thread){
+        int* count = &offsets[size_t(r)*nBuckets];
+        for(int c = rangeBegin(r); c < rangeBegin(r+1); c++){
+            int b = int(HashKey128()(key(c)) >> (64-bucketBits));
+            cornerBucket[c] = b;
+            count[b]++;
+        }
+    },1);
+    std::vector<int> bucketBegin = std::vector<int>(nBuckets+1,0);
+    int total = 0;
+    for(int b = 0; b < nBuckets; b++){
+        bucketBegin[b] = total;
+        for(int r = 0; r < nRanges; r++){
+            int count = offsets[size_t(r)*nBuckets+b];
+            offsets[size_t(r)*nBuckets+b] = total;
+            total += count;
+        }
+    }
+    bucketBegin[nBuckets] = total;
+    std::vector<int> sorted = std::vector<int>(n);
+    par::parallelFor(nRanges,nThreads,[&](int r, int thread){
+        int* next = &offsets[size_t(r)*nBuckets];
+        for(int c = rangeBegin(r); c < rangeBegin(r+1); c++){
+            sorted[next[cornerBucket[c]]++] = c;
+        }
+    },1);
+
+    //equal triples land in the same bucket, the first corner of a triple in the bucket is its first in the file
+    std::vector<int>& firstCorner = cornerBucket; //reused, the bucket of a corner isnt needed anymore
+    par::parallelFor(nBuckets,nThreads,[&](int b, int thread){
+        int begin = bucketBegin[b];
+        int end = bucketBegin[b+1];
+        FlatHashTable<uuid128,int,HashKey128> table = FlatHashTable<uuid128,int,HashKey128>(int(log2(double(end-begin)+1))+1);
+        for(int i = begin; i < end; i++){
+            int c = sorted[i];
+            uuid128 k = key(c);
+            int* first = table.getPtr(k);
+            if(first){
+                firstCorner[c] = *first;
+            } else {
+                table.add(c,k);
+                firstCorner[c] = c;
+            }
+        }
+    },1);
+
+    //number the first corners in file order, every other corner takes the vertex of its first corner
+    std::vector<int> rangeVertices = std::vector<int>(nRanges+1,0);
+    par::parallelFor(nRanges,nThreads,[&](int r, int thread){
+        int count = 0;
+        for(int c = rangeBegin(r); c < rangeBegin(r+1); c++){
+            count += firstCorner[c] == c;
+        }
+        rangeVertices[r+1] = count;
+    },1);
+    for(int r = 0; r < nRanges; r++){
+        rangeVertices[r+1] += rangeVertices[r];
+    }
+    vertexCorner.resize(rangeVertices[nRanges]);
+    par::parallelFor(nRanges,nThreads,[&](int r, int thread){
+        int v = rangeVertices[r];
+        for(int c = rangeBegin(r); c < rangeBegin(r+1); c++){
+            if(firstCorner[c] == c){
+                cornerVertex[c] = v;
+                vertexCorner[v] = c;
+                v++;
+            }
+        }
+    },1);
+    par::parallelFor(nRanges,nThreads,[&](int r, int thread){
+        for(int c = rangeBegin(r); c < rangeBegin(r+1); c++){
+            cornerVertex[c] = cornerVertex[firstCorner[c]];
+        }
+    },1);
+}
+
+/**
+ * @brief Fills in what a mesh file didnt provide so the objItem looks like one from loadOBJFile:
+ * vertex normals are computed from the facets and texture coordinates are zero
+ *
+ * @param item
+ * @param hasNormals
+ * @param hasTextCoords
+ */
+static void completeItem(objItem* item, bool hasNormals, bool hasTextCoords){
+    if(!hasNormals){
+        std::vector<geo::Facet> facets = std::vector<geo::Facet>(item->indices.size()/3);
+        for(size_t i = 0; i < facets.size(); i++){
+            facets[i] = geo::Facet(item->indices[i*3+0],item->indices[i*3+1],item->indices[i*3+2]);
+        }
+        geo::vertexNormals(facets,item->positions,item->normals);
+    }
+    if(!hasTextCoords){
+        item->textCoords = std::vector<cgVec2>(item->positions.size(),cgVec2(0,0));
+    }
+}
+
+/**
+ * @brief Builds the vertices of one object from the index triples of its facets, every unique
+ * (position, texture coordinate, normal) triple becomes one vertex, numbered in the order it first appears.
+ * Corners without a texture coordinate get (0,0), if any corner has no normal the normals of the whole object
+ * are computed from the facets. Shared by both obj loaders so they produce the same objItems.
+ *
+ * @param item object receiving the vertex data and indices
+ * @param positions positions of the whole file
+ * @param textCoords texture coordinates of the whole file
+ * @param normals normals of the whole file
+ * @param vertexPosIndices 1 based position index of every facet corner of the object
+ * @param textPosIndices 1 based texture coordinate index of every facet corner, 0 if it has none
+ * @param normalIndices 1 based normal index of every facet corner, 0 if it has none
+ * @param nThreads
+ */
+static void assembleObject(objItem* item, std::vector<cgVec3>& positions, std::vector<cgVec2>& textCoords, std::vector<cgVec3>& normals,
+                           std::vector<int>& vertexPosIndices, std::vector<int>& textPosIndices, std::vector<int>& normalIndices, int nThreads){
+    std::vector<int> vertexCorner;
+    dedupeCorners(vertexPosIndices,textPosIndices,normalIndices,nThreads,item->indices,vertexCorner);
+
+    int nVertices = int(vertexCorner.size());
+    item->positions.resize(nVertices);
+    item->textCoords.resize(nVertices);
+    item->normals.resize(nVertices);
+    par::parallelFor(nVertices,nThreads,[&](int v, int thread){
+        int c = vertexCorner[v];
+        item->positions[v] = positions[vertexPosIndices[c]-1];
+        int t = textPosIndices[c];
+        int n = normalIndices[c];
+        item->textCoords[v] = t > 0 ? textCoords[t-1] : cgVec2(0,0);
+        item->normals[v] = n > 0 ? normals[n-1] : cgVec3(0,0,0);
+    },4096);
+    completeItem(item,std::find(normalIndices.begin(),normalIndices.end(),0) == normalIndices.end(),true);
+}
+
+static bool parseOBJFace(const char* p, const char* end, int* inds); //below with the other parsing helpers
 
 void loadOBJFile(std::string filename, std::vector<objItem*>& target, std::string object_id){
     std::string pathSeparator = "/";
@@ -28,7 +234,6 @@ void loadOBJFile(std::string filename, std::vector<objItem*>& target, std::strin
     std::string mtllib;
 
     bool isFirstObject = true;
-    bool onFirstObject = false;
 
     while(1){
         
@@ -40,6 +245,8 @@ void loadOBJFile(std::string filename, std::vector<objItem*>& target, std::strin
         if ( strcmp( lineHeader, "o" ) == 0 || strcmp( lineHeader, "g" ) == 0 || res == EOF ){ //new object, constructs previous object
             if(res!=EOF){
                 fscanf(file, "%s",objName);
+            } else {
+                objName[0] = 0;
             }
 
             if(isFirstObject){ //if its the first object in the file, we dont want to assemble the previous mesh since there isnt one...
@@ -48,48 +255,13 @@ void loadOBJFile(std::string filename, std::vector<objItem*>& target, std::strin
                 target[target.size()-1]->name = std::string(objName);
                 target[target.size()-1]->filename = filename;
                 isFirstObject = false;
-                onFirstObject = true;
                 continue;
             }
             
             //assemble last mesh
             if(target.size()>0){
-                if(onFirstObject){
-                    onFirstObject = false;
-                } else {
-                    target[target.size()-1]->name = std::string(objName);
-                    target[target.size()-1]->filename = filename;
-                }
-            
-                //assemble mesh for this object here
-                std::vector<vertIndices> vIndices; //using Facets since they are 3 integers with a getKey() method
-                                                // then the set union can be used to get rid of duplicates
-                for(int i = 0; i < vertexPosIndices.size(); i++){
-                    vIndices.push_back(vertIndices(vertexPosIndices[i]-1,textPosIndices[i]-1,normalIndices[i]-1));
-                }
-                std::vector<vertIndices> nullSet;
-                std::vector<vertIndices> setNoDupes; 
-                //taking the union with an empty set efficiently removes duplicates
-                setUnion<vertIndices>(vIndices,nullSet, setNoDupes);
-
-                //this will map a set of indices to a single index so we can find the indices that 
-                //vIndices map to in the obj target arrays.
-
-                HashTable_s128<int> indexMap = HashTable_s128<int>(10);
-                //get actual vertex data
-                int ind = 0;
-                for(vertIndices f : setNoDupes){
-                    target[target.size()-1]->positions.push_back(tempVertPositions[f.inds[0]]);
-                    target[target.size()-1]->textCoords.push_back(tempTextPos[f.inds[1]]);
-                    target[target.size()-1]->normals.push_back(tempVertNormals[f.inds[2]]);
-                    indexMap.add(ind,f.getKey128());
-                    ind++;
-                }
-
-                //index to the compiled vertex data
-                for(vertIndices f : vIndices){
-                    target[target.size()-1]->indices.push_back(indexMap.get(f.getKey128()));
-                }
+                assembleObject(target[target.size()-1],tempVertPositions,tempTextPos,tempVertNormals,
+                               vertexPosIndices,textPosIndices,normalIndices,par::numThreads(0));
                 target[target.size()-1]->mtllib = mtllib;
                 //delete indices so that they are fresh for the next object
                 vertexPosIndices.clear();
@@ -101,6 +273,8 @@ void loadOBJFile(std::string filename, std::vector<objItem*>& target, std::strin
             }
             //generate next object...
             target.push_back(new objItem());
+            target[target.size()-1]->name = std::string(objName);
+            target[target.size()-1]->filename = filename;
         }else if ( strcmp( lineHeader, "mtllib" ) == 0 ){ //mtl file specification, load mtl data
             char mtlfilename[128];
             fscanf(file, "%s", mtlfilename); //read filename
@@ -136,25 +310,890 @@ void loadOBJFile(std::string filename, std::vector<objItem*>& target, std::strin
             tempVertNormals.push_back(normal);
             
         }else if ( strcmp( lineHeader, "f" ) == 0 ){
-            unsigned int vertexIndex[3], uvIndex[3], normalIndex[3];
-            int matches = fscanf(file, "%d/%d/%d %d/%d/%d %d/%d/%d\n", &vertexIndex[0], &uvIndex[0], &normalIndex[0], &vertexIndex[1], &uvIndex[1], &normalIndex[1], &vertexIndex[2], &uvIndex[2], &normalIndex[2] );
-            if (matches != 9){
+            char line[1024] = {0};
+            int inds[9]; //position/texture coordinate/normal index of each corner, 0 if missing
+            if (!fgets(line,1024,file) || !parseOBJFace(line,line+strcspn(line,"\n"),inds)){
                 std::cout << lineHeader<<"\n";
-                char line[1024];
-                std::cout << fgets(line,1024,file);
+                std::cout << line;
                 printf("OBJ File can't be read, Make sure that file is Triangulated \n");
                 exit(-1);
             }
-            vertexPosIndices.push_back(vertexIndex[0]);
-            vertexPosIndices.push_back(vertexIndex[1]);
-            vertexPosIndices.push_back(vertexIndex[2]);
-            textPosIndices  .push_back(uvIndex[0]);
-            textPosIndices  .push_back(uvIndex[1]);
-            textPosIndices  .push_back(uvIndex[2]);
-            normalIndices.push_back(normalIndex[0]);
-            normalIndices.push_back(normalIndex[1]);
-            normalIndices.push_back(normalIndex[2]);
+            vertexPosIndices.push_back(inds[0]);
+            vertexPosIndices.push_back(inds[3]);
+            vertexPosIndices.push_back(inds[6]);
+            textPosIndices  .push_back(inds[1]);
+            textPosIndices  .push_back(inds[4]);
+            textPosIndices  .push_back(inds[7]);
+            normalIndices.push_back(inds[2]);
+            normalIndices.push_back(inds[5]);
+            normalIndices.push_back(inds[8]);
         }
     }
     fclose(file);
-}
\ No newline at end of file
+}
+enum OBJEventType{
+    OBJ_EVENT_OBJECT, //"o" or "g", starts a new object
+    OBJ_EVENT_MTLLIB,
+    OBJ_EVENT_USEMTL
+};
+
+//a record which isnt vertex data, kept in file order so the chunks can be stitched back together
+struct OBJEvent{
+    OBJEventType type;
+    size_t face = 0; //number of facets of the chunk read before the record
+    std::string name;
+};
+
+//everything parsed from one chunk of the file, in the order it appears
+struct OBJChunk{
+    std::vector<cgVec3> positions;
+    std::vector<cgVec2> textCoords;
+    std::vector<cgVec3> normals;
+    std::vector<int> faces; //9 per facet, position/texture coordinate/normal index of each corner (0 if missing)
+    std::vector<OBJEvent> events;
+    bool failed = false;
+    std::string badLine; //first facet which doesnt start with 3 corners
+};
+
+static inline bool isBlank(char c){
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline const char* skipBlanks(const char* p, const char* end){
+    while(p < end && isBlank(*p)){
+        p++;
+    }
+    return p;
+}
+
+static inline const char* tokenEnd(const char* p, const char* end){
+    while(p < end && !isBlank(*p)){
+        p++;
+    }
+    return p;
+}
+
+/**
+ * @brief Parses a float the way strtof does. Plain decimals whose value is exact in double arithmetic
+ * are converted directly, everything else (long mantissas, large exponents, inf/nan/hex and the rare value
+ * which rounds to a float halfway point) is handed to strtof so the result is always the correctly rounded float.
+ *
+ * @param p start of the number, leading blanks are skipped
+ * @param end end of the line
+ * @param value
+ * @return const char* first character after the number
+ */
+static const char* parseFloat(const char* p, const char* end, float& value){
+    static const double pow10[] = {1e0,1e1,1e2,1e3,1e4,1e5,1e6,1e7,1e8,1e9,1e10,1e11,
+                                   1e12,1e13,1e14,1e15,1e16,1e17,1e18,1e19,1e20,1e21,1e22};
+    p = skipBlanks(p,end);
+    const char* start = p;
+    bool negative = false;
+    if(p < end && (*p == '-' || *p == '+')){
+        negative = *p == '-';
+        p++;
+    }
+    uint64_t mantissa = 0;
+    int nDigits = 0; //significant digits in mantissa
+    int exponent = 0;
+    bool exact = true;
+    bool anyDigits = false;
+    for(; p < end && *p >= '0' && *p <= '9'; p++){
+        anyDigits = true;
+        if(nDigits < 19){
+            mantissa = mantissa*10 + uint64_t(*p-'0');
+            nDigits += mantissa != 0;
+        } else {
+            exponent++;
+            exact = false;
+        }
+    }
+    if(p < end && *p == '.'){
+        p++;
+        for(; p < end && *p >= '0' && *p <= '9'; p++){
+            anyDigits = true;
+            if(nDigits < 19){
+                mantissa = mantissa*10 + uint64_t(*p-'0');
+                nDigits += mantissa != 0;
+                exponent--;
+            } else {
+                exact = false;
+            }
+        }
+    }
+    if(anyDigits && p < end && (*p == 'e' || *p == 'E')){
+        const char* q = p+1;
+        bool negativeExponent = false;
+        if(q < end && (*q == '-' || *q == '+')){
+            negativeExponent = *q == '-';
+            q++;
+        }
+        if(q < end && *q >= '0' && *q <= '9'){
+            int e = 0;
+            for(; q < end && *q >= '0' && *q <= '9'; q++){
+                e = std::min(e*10 + (*q-'0'),100000);
+            }
+            exponent += negativeExponent ? -e : e;
+            p = q;
+        }
+    }
+    if(anyDigits && exact && (p == end || isBlank(*p) || *p == '\n') && mantissa <= (uint64_t(1) << 53)){
+        if(mantissa == 0){
+            value = negative ? -0.0f : 0.0f;
+            return p;
+        }
+        if(exponent >= -22 && exponent <= 22){
+            double d = exponent < 0 ? double(mantissa)/pow10[-exponent] : double(mantissa)*pow10[exponent];
+            float f = float(d);
+            //d is correctly rounded, so rounding it again to float is only wrong if it landed exactly halfway between two floats
+            bool halfway = false;
+            if(double(f) != d){
+                float g = nextafterf(f,d > double(f) ? INFINITY : -INFINITY);
+                halfway = (double(f)+double(g))*0.5 == d;
+            }
+            if(!halfway){
+                value = negative ? -f : f;
+                return p;
+            }
+        }
+    }
+    //slow path, strtof needs a terminated copy of the token
+    const char* last = tokenEnd(start,end);
+    std::string token = std::string(start,last);
+    char* stop = nullptr;
+    value = strtof(token.c_str(),&stop);
+    return start + (stop - token.c_str());
+}
+
+/**
+ * @brief Parses a decimal integer
+ *
+ * @param p start of the number
+ * @param end end of the line
+ * @param value
+ * @return const char* first character after the number, or nullptr if there are no digits
+ */
+static const char* parseInt(const char* p, const char* end, int& value){
+    bool negative = false;
+    if(p < end && (*p == '-' || *p == '+')){
+        negative = *p == '-';
+        p++;
+    }
+    if(p == end || *p < '0' || *p > '9'){
+        return nullptr;
+    }
+    int v = 0;
+    for(; p < end && *p >= '0' && *p <= '9'; p++){
+        v = v*10 + (*p-'0');
+    }
+    value = negative ? -v : v;
+    return p;
+}
+
+/**
+ * @brief Parses one corner of a facet, written v, v/vt, v//vn or v/vt/vn
+ *
+ * @param p start of the corner
+ * @param end end of the line
+ * @param corner receives the position, texture coordinate and normal index, 0 for the missing ones
+ * @return const char* first character after the corner, or nullptr if it isnt a corner
+ */
+static const char* parseOBJCorner(const char* p, const char* end, int* corner){
+    corner[1] = 0;
+    corner[2] = 0;
+    p = parseInt(p,end,corner[0]);
+    if(p && p < end && *p == '/'){
+        p++;
+        if(p < end && *p != '/'){
+            p = parseInt(p,end,corner[1]);
+        }
+        if(p && p < end && *p == '/'){
+            p = parseInt(p+1,end,corner[2]);
+        }
+    }
+    return (p && (p == end || isBlank(*p))) ? p : nullptr;
+}
+
+/**
+ * @brief Parses the 3 corners of an "f" line (after the "f"), shared by both obj loaders
+ *
+ * @param p
+ * @param end end of the line
+ * @param inds receives 3 indices per corner, see parseOBJCorner
+ * @return false if the line doesnt start with 3 corners
+ */
+static bool parseOBJFace(const char* p, const char* end, int* inds){
+    for(int corner = 0; corner < 3 && p; corner++){
+        p = parseOBJCorner(skipBlanks(p,end),end,inds+corner*3);
+    }
+    return p != nullptr;
+}
+
+/**
+ * @brief Parses one line of an obj file into chunk
+ *
+ * @param p start of the line
+ * @param end end of the line, excluding the newline
+ * @param chunk
+ */
+static void parseOBJLine(const char* p, const char* end, OBJChunk& chunk){
+    p = skipBlanks(p,end);
+    const char* headerEnd = tokenEnd(p,end);
+    size_t headerLength = size_t(headerEnd-p);
+    if(headerLength == 0 || headerLength > 6){
+        return;
+    }
+    char header[8] = {0};
+    memcpy(header,p,headerLength);
+    p = headerEnd;
+
+    if(strcmp(header,"v") == 0){
+        cgVec3 vertPos;
+        p = parseFloat(p,end,vertPos.x);
+        p = parseFloat(p,end,vertPos.y);
+        parseFloat(p,end,vertPos.z);
+        chunk.positions.push_back(vertPos);
+    } else if(strcmp(header,"vt") == 0){
+        cgVec2 textPos;
+        p = parseFloat(p,end,textPos.x);
+        parseFloat(p,end,textPos.y);
+        chunk.textCoords.push_back(textPos);
+    } else if(strcmp(header,"vn") == 0){
+        cgVec3 normal;
+        p = parseFloat(p,end,normal.x);
+        p = parseFloat(p,end,normal.y);
+        parseFloat(p,end,normal.z);
+        chunk.normals.push_back(normal);
+    } else if(strcmp(header,"f") == 0){
+        int inds[9];
+        if(!parseOBJFace(p,end,inds)){
+            if(!chunk.failed){
+                chunk.failed = true;
+                chunk.badLine = std::string(header) + std::string(p,end);
+            }
+            return;
+        }
+        chunk.faces.insert(chunk.faces.end(),inds,inds+9);
+    } else if(strcmp(header,"o") == 0 || strcmp(header,"g") == 0 || strcmp(header,"mtllib") == 0 || strcmp(header,"usemtl") == 0){
+        OBJEvent event;
+        event.type = header[0] == 'm' ? OBJ_EVENT_MTLLIB : (header[0] == 'u' ? OBJ_EVENT_USEMTL : OBJ_EVENT_OBJECT);
+        event.face = chunk.faces.size()/9;
+        p = skipBlanks(p,end);
+        event.name = std::string(p,tokenEnd(p,end));
+        chunk.events.push_back(event);
+    }
+}
+
+/**
+ * @brief Parses the whole lines starting in [begin,end) of the file
+ *
+ * @param begin
+ * @param end
+ * @param chunk
+ */
+static void parseOBJChunk(const char* begin, const char* end, OBJChunk& chunk){
+    const char* p = begin;
+    while(p < end){
+        const char* lineEnd = (const char*)memchr(p,'\n',size_t(end-p));
+        if(!lineEnd){
+            lineEnd = end;
+        }
+        parseOBJLine(p,lineEnd,chunk);
+        p = lineEnd+1;
+    }
+}
+
+/**
+ * @brief Concatenates the same array of every chunk, each chunk is copied by its own thread
+ *
+ * @tparam T
+ * @param chunks
+ * @param member the array to concatenate
+ * @param nThreads
+ * @param target
+ */
+template <class T>
+static void concatChunks(std::vector<OBJChunk>& chunks, std::vector<T> OBJChunk::*member, int nThreads, std::vector<T>& target){
+    std::vector<size_t> offsets = std::vector<size_t>(chunks.size()+1,0);
+    for(size_t c = 0; c < chunks.size(); c++){
+        offsets[c+1] = offsets[c] + (chunks[c].*member).size();
+    }
+    target.resize(offsets.back());
+    par::parallelFor(int(chunks.size()),nThreads,[&](int c, int thread){
+        std::vector<T>& source = chunks[c].*member;
+        std::copy(source.begin(),source.end(),target.begin()+offsets[c]);
+        std::vector<T>().swap(source);
+    },1);
+}
+
+/**
+ * @brief Reports why a mesh file couldnt be loaded through error (if not nullptr)
+ *
+ * @param error
+ * @param message
+ * @return false
+ */
+static bool meshLoadError(std::string* error, const std::string& message){
+    if(error){
+        *error = message;
+    }
+    return false;
+}
+
+bool loadOBJFileMapped(std::string filename, std::vector<objItem*>& target, std::string object_id, int nThreads, std::string* error){
+    MappedFile file;
+    if(!file.open(filename)){
+        return meshLoadError(error,"could not open the file");
+    }
+    nThreads = par::numThreads(nThreads);
+    const char* data = file.data();
+    size_t size = file.size();
+
+    //a few chunks per thread so uneven lines still balance, but no chunk smaller than a megabyte
+    const size_t minChunkSize = 1 << 20;
+    size_t nChunks = std::max(size_t(1),std::min(size_t(nThreads)*4,size/minChunkSize));
+    std::vector<size_t> bounds = std::vector<size_t>(nChunks+1,size);
+    bounds[0] = 0;
+    for(size_t c = 1; c < nChunks; c++){
+        size_t b = std::max(bounds[c-1],size/nChunks*c);
+        const char* newline = b < size ? (const char*)memchr(data+b,'\n',size-b) : nullptr;
+        bounds[c] = newline ? size_t(newline-data)+1 : size;
+    }
+    std::vector<OBJChunk> chunks = std::vector<OBJChunk>(nChunks);
+    par::parallelFor(int(nChunks),nThreads,[&](int c, int thread){
+        parseOBJChunk(data+bounds[c],data+bounds[c+1],chunks[c]);
+    },1);
+    file.close();
+
+    for(OBJChunk& chunk : chunks){
+        if(chunk.failed){
+            return meshLoadError(error,"can't read \"" + chunk.badLine + "\", make sure that the file is triangulated");
+        }
+    }
+
+    std::vector<cgVec3> positions;
+    std::vector<cgVec2> textCoords;
+    std::vector<cgVec3> normals;
+    concatChunks(chunks,&OBJChunk::positions,nThreads,positions);
+    concatChunks(chunks,&OBJChunk::textCoords,nThreads,textCoords);
+    concatChunks(chunks,&OBJChunk::normals,nThreads,normals);
+
+    //replay the records in file order, the facets read since the last "o"/"g" belong to the current object
+    //and the facets before the first one go to the first object
+    std::vector<objItem*> objects;
+    std::vector<std::vector<int>> objectFaces;
+    std::vector<int> faces;
+    std::string mtllib;
+    objItem* current = nullptr;
+    size_t first = target.size();
+    auto finishObject = [&](){
+        current->mtllib = mtllib;
+        objects.push_back(current);
+        objectFaces.push_back(std::vector<int>());
+        objectFaces.back().swap(faces);
+    };
+    auto startObject = [&](const std::string& name){
+        current = new objItem();
+        current->name = name;
+        current->filename = filename;
+        target.push_back(current);
+    };
+    for(OBJChunk& chunk : chunks){
+        size_t face = 0;
+        for(OBJEvent& event : chunk.events){
+            faces.insert(faces.end(),chunk.faces.begin()+face*9,chunk.faces.begin()+event.face*9);
+            face = event.face;
+            if(event.type == OBJ_EVENT_OBJECT){
+                if(current){
+                    finishObject();
+                }
+                startObject(event.name);
+            } else if(event.type == OBJ_EVENT_MTLLIB){
+                mtllib = event.name;
+            } else if(current){
+                current->matName = event.name;
+            }
+        }
+        faces.insert(faces.end(),chunk.faces.begin()+face*9,chunk.faces.end());
+        std::vector<int>().swap(chunk.faces);
+    }
+    if(!current){
+        startObject("");
+    }
+    finishObject();
+
+    //a corner indexing past the arrays (a cut off or broken file) would be read out of bounds when assembling
+    std::vector<uint8_t> badIndex = std::vector<uint8_t>(objects.size(),0);
+    int nPositions = int(positions.size()), nTextCoords = int(textCoords.size()), nNormals = int(normals.size());
+    par::parallelFor(int(objects.size()),nThreads,[&](int m, int thread){
+        std::vector<int>& corners = objectFaces[m];
+        for(size_t i = 0; i+2 < corners.size(); i += 3){
+            if(corners[i] < 1 || corners[i] > nPositions || corners[i+1] < 0 || corners[i+1] > nTextCoords ||
+               corners[i+2] < 0 || corners[i+2] > nNormals){
+                badIndex[m] = 1;
+                break;
+            }
+        }
+    },1);
+    if(std::find(badIndex.begin(),badIndex.end(),1) != badIndex.end()){
+        for(size_t i = first; i < target.size(); i++){
+            delete target[i];
+        }
+        target.resize(first);
+        return meshLoadError(error,"a face references a vertex, texture coordinate or normal which doesnt exist");
+    }
+
+    //the objects only read the shared arrays, so they are assembled concurrently.
+    //threads left over when there are fewer objects than threads go to the corners of each object
+    int nWorkers = std::max(1,std::min(nThreads,int(objects.size())));
+    int objectThreads = std::max(1,nThreads/nWorkers);
+    par::parallelFor(int(objects.size()),nWorkers,[&](int m, int thread){
+        std::vector<int>& corners = objectFaces[m];
+        size_t nCorners = corners.size()/3;
+        std::vector<int> vertexPosIndices = std::vector<int>(nCorners);
+        std::vector<int> textPosIndices = std::vector<int>(nCorners);
+        std::vector<int> normalIndices = std::vector<int>(nCorners);
+        for(size_t i = 0; i < nCorners; i++){
+            vertexPosIndices[i] = corners[i*3+0];
+            textPosIndices[i] = corners[i*3+1];
+            normalIndices[i] = corners[i*3+2];
+        }
+        std::vector<int>().swap(corners);
+        assembleObject(objects[m],positions,textCoords,normals,vertexPosIndices,textPosIndices,normalIndices,objectThreads);
+    },1);
+    return true;
+}
+
+enum PLYType{
+    PLY_INT8, PLY_UINT8, PLY_INT16, PLY_UINT16, PLY_INT32, PLY_UINT32, PLY_FLOAT32, PLY_FLOAT64, PLY_INVALID
+};
+
+struct PLYProperty{
+    std::string name;
+    PLYType type = PLY_INVALID; //type of the value, or of the list entries
+    PLYType countType = PLY_INVALID; //type of the list length, PLY_INVALID for scalar properties
+    size_t offset = 0; //byte offset in the record, only meaningful while the element has no lists
+};
+
+struct PLYElement{
+    std::string name;
+    size_t count = 0;
+    std::vector<PLYProperty> properties;
+    size_t stride = 0; //record size, 0 if the element has list properties
+};
+
+static PLYType plyType(const std::string& name){
+    static const char* names[][2] = {{"char","int8"},{"uchar","uint8"},{"short","int16"},{"ushort","uint16"},
+                                     {"int","int32"},{"uint","uint32"},{"float","float32"},{"double","float64"}};
+    for(int t = 0; t < 8; t++){
+        if(name == names[t][0] || name == names[t][1]){
+            return PLYType(t);
+        }
+    }
+    return PLY_INVALID;
+}
+
+static size_t plySize(PLYType type){
+    static const size_t sizes[] = {1,1,2,2,4,4,4,8,0};
+    return sizes[type];
+}
+
+static double plyRead(PLYType type, const char* p){
+    switch(type){
+        case PLY_INT8: {int8_t v; memcpy(&v,p,1); return v;}
+        case PLY_UINT8: {uint8_t v; memcpy(&v,p,1); return v;}
+        case PLY_INT16: {int16_t v; memcpy(&v,p,2); return v;}
+        case PLY_UINT16: {uint16_t v; memcpy(&v,p,2); return v;}
+        case PLY_INT32: {int32_t v; memcpy(&v,p,4); return v;}
+        case PLY_UINT32: {uint32_t v; memcpy(&v,p,4); return v;}
+        case PLY_FLOAT32: {float v; memcpy(&v,p,4); return v;}
+        case PLY_FLOAT64: {double v; memcpy(&v,p,8); return v;}
+        default: return 0;
+    }
+}
+
+/**
+ * @brief Index of the first property of element called one of names, or -1
+ *
+ */
+static int findProperty(PLYElement& element, std::initializer_list<const char*> names){
+    for(const char* name : names){
+        for(size_t i = 0; i < element.properties.size(); i++){
+            if(element.properties[i].name == name){
+                return int(i);
+            }
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Size in bytes of one record of element starting at p, or 0 if it runs past end
+ *
+ */
+static size_t plyRecordSize(PLYElement& element, const char* p, const char* end){
+    if(element.stride > 0){
+        return size_t(end-p) >= element.stride ? element.stride : 0;
+    }
+    const char* q = p;
+    for(PLYProperty& property : element.properties){
+        if(property.countType != PLY_INVALID){
+            if(size_t(end-q) < plySize(property.countType)){
+                return 0;
+            }
+            size_t n = size_t(plyRead(property.countType,q));
+            q += plySize(property.countType);
+            if(size_t(end-q)/plySize(property.type) < n){
+                return 0;
+            }
+            q += n*plySize(property.type);
+        } else {
+            if(size_t(end-q) < plySize(property.type)){
+                return 0;
+            }
+            q += plySize(property.type);
+        }
+    }
+    return size_t(q-p);
+}
+
+bool loadPLYFile(std::string filename, std::vector<objItem*>& target, std::string object_id, int nThreads, std::string* error){
+    MappedFile file;
+    if(!file.open(filename)){
+        return meshLoadError(error,"could not open the file");
+    }
+    nThreads = par::numThreads(nThreads);
+    const char* p = file.data();
+    const char* end = p + file.size();
+
+    //ascii header, one keyword per line
+    std::vector<PLYElement> elements;
+    bool binaryLittleEndian = false;
+    bool headerDone = false;
+    int lineNumber = 0;
+    while(p < end && !headerDone){
+        const char* lineEnd = (const char*)memchr(p,'\n',size_t(end-p));
+        if(!lineEnd){
+            break;
+        }
+        std::vector<std::string> words;
+        const char* q = skipBlanks(p,lineEnd);
+        while(q < lineEnd){
+            const char* w = tokenEnd(q,lineEnd);
+            words.push_back(std::string(q,w));
+            q = skipBlanks(w,lineEnd);
+        }
+        p = lineEnd+1;
+        if(lineNumber++ == 0){
+            if(words.size() != 1 || words[0] != "ply"){
+                return meshLoadError(error,"not a PLY file");
+            }
+        } else if(words.empty() || words[0] == "comment" || words[0] == "obj_info"){
+            continue;
+        } else if(words[0] == "format"){
+            binaryLittleEndian = words.size() > 1 && words[1] == "binary_little_endian";
+        } else if(words[0] == "element" && words.size() == 3){
+            PLYElement element;
+            element.name = words[1];
+            element.count = size_t(strtoull(words[2].c_str(),nullptr,10));
+            elements.push_back(element);
+        } else if(words[0] == "property" && !elements.empty()){
+            PLYProperty property;
+            if(words.size() == 5 && words[1] == "list"){
+                property.countType = plyType(words[2]);
+                property.type = plyType(words[3]);
+                property.name = words[4];
+                if(property.countType == PLY_INVALID || property.countType == PLY_FLOAT32 || property.countType == PLY_FLOAT64){
+                    return meshLoadError(error,"unsupported PLY list length type");
+                }
+            } else if(words.size() == 3){
+                property.type = plyType(words[1]);
+                property.name = words[2];
+            }
+            if(property.type == PLY_INVALID){
+                return meshLoadError(error,"unsupported PLY property type");
+            }
+            elements.back().properties.push_back(property);
+        } else if(words[0] == "end_header"){
+            headerDone = true;
+        }
+    }
+    if(!headerDone){
+        return meshLoadError(error,"the PLY header has no end_header");
+    }
+    if(!binaryLittleEndian){
+        return meshLoadError(error,"only binary little endian PLY files are supported");
+    }
+    for(PLYElement& element : elements){
+        size_t offset = 0;
+        bool hasList = false;
+        for(PLYProperty& property : element.properties){
+            property.offset = offset;
+            offset += plySize(property.type);
+            hasList = hasList || property.countType != PLY_INVALID;
+        }
+        element.stride = hasList ? 0 : offset;
+    }
+
+    std::unique_ptr<objItem> item = std::unique_ptr<objItem>(new objItem()); //not in target until it loaded
+    item->name = std::filesystem::path(filename).stem().string();
+    item->filename = filename;
+    bool hasNormals = false;
+    bool hasTextCoords = false;
+    for(PLYElement& element : elements){
+        if(element.name == "vertex"){
+            int x = findProperty(element,{"x"}), y = findProperty(element,{"y"}), z = findProperty(element,{"z"});
+            int nx = findProperty(element,{"nx"}), ny = findProperty(element,{"ny"}), nz = findProperty(element,{"nz"});
+            int u = findProperty(element,{"u","s","texture_u","texture_s"}), v = findProperty(element,{"v","t","texture_v","texture_t"});
+            if(x < 0 || y < 0 || z < 0 || element.stride == 0){
+                return meshLoadError(error,"PLY vertices need x, y and z and no list properties");
+            }
+            if(size_t(end-p)/element.stride < element.count){
+                return meshLoadError(error,"the PLY file is truncated");
+            }
+            size_t n = element.count;
+            size_t stride = element.stride;
+            std::vector<PLYProperty>& props = element.properties;
+            item->positions.resize(n);
+            hasNormals = nx >= 0 && ny >= 0 && nz >= 0;
+            hasTextCoords = u >= 0 && v >= 0;
+            bool packedFloats = props[x].type == PLY_FLOAT32 && props[y].type == PLY_FLOAT32 && props[z].type == PLY_FLOAT32 &&
+                                props[x].offset == 0 && props[y].offset == 4 && props[z].offset == 8;
+            if(packedFloats && stride == sizeof(cgVec3)){
+                memcpy(item->positions.data(),p,n*sizeof(cgVec3)); //the whole element is the positions array
+            } else {
+                const char* base = p;
+                par::parallelFor(int(n),nThreads,[&](int i, int thread){
+                    const char* record = base + size_t(i)*stride;
+                    cgVec3& pos = item->positions[i];
+                    if(packedFloats){
+                        memcpy(&pos,record,sizeof(cgVec3));
+                    } else {
+                        pos = cgVec3(float(plyRead(props[x].type,record+props[x].offset)),float(plyRead(props[y].type,record+props[y].offset)),
+                                     float(plyRead(props[z].type,record+props[z].offset)));
+                    }
+                },4096);
+            }
+            if(hasNormals || hasTextCoords){
+                item->normals.resize(hasNormals ? n : 0);
+                item->textCoords.resize(hasTextCoords ? n : 0);
+                const char* base = p;
+                par::parallelFor(int(n),nThreads,[&](int i, int thread){
+                    const char* record = base + size_t(i)*stride;
+                    if(hasNormals){
+                        item->normals[i] = cgVec3(float(plyRead(props[nx].type,record+props[nx].offset)),float(plyRead(props[ny].type,record+props[ny].offset)),
+                                                  float(plyRead(props[nz].type,record+props[nz].offset)));
+                    }
+                    if(hasTextCoords){
+                        item->textCoords[i] = cgVec2(float(plyRead(props[u].type,record+props[u].offset)),float(plyRead(props[v].type,record+props[v].offset)));
+                    }
+                },4096);
+            }
+            p += n*stride;
+        } else if(element.name == "face"){
+            int list = findProperty(element,{"vertex_indices","vertex_index"});
+            if(list < 0 || element.properties[list].countType == PLY_INVALID){
+                return meshLoadError(error,"PLY faces need a vertex_indices list");
+            }
+            PLYProperty& indices = element.properties[list];
+            size_t n = element.count;
+            //the common layout (just a uchar count and int indices per face) with only triangles is copied in bulk
+            bool bulk = element.properties.size() == 1 && indices.countType == PLY_UINT8 &&
+                        (indices.type == PLY_INT32 || indices.type == PLY_UINT32) && size_t(end-p)/13 >= n;
+            for(size_t i = 0; bulk && i < n; i++){
+                bulk = p[i*13] == 3;
+            }
+            if(bulk){
+                item->indices.resize(n*3);
+                const char* base = p;
+                par::parallelFor(int(n),nThreads,[&](int i, int thread){
+                    memcpy(&item->indices[size_t(i)*3],base+size_t(i)*13+1,12);
+                },4096);
+                p += n*13;
+            } else {
+                //anything else is read face by face, polygons are split into fans
+                item->indices.reserve(n*3);
+                for(size_t i = 0; i < n; i++){
+                    size_t recordSize = plyRecordSize(element,p,end);
+                    if(recordSize == 0){
+                        return meshLoadError(error,"the PLY file is truncated");
+                    }
+                    const char* q = p;
+                    for(size_t k = 0; k < element.properties.size(); k++){
+                        PLYProperty& property = element.properties[k];
+                        if(property.countType == PLY_INVALID){
+                            q += plySize(property.type);
+                            continue;
+                        }
+                        size_t nCorners = size_t(plyRead(property.countType,q));
+                        q += plySize(property.countType);
+                        if(int(k) == list){
+                            size_t size = plySize(property.type);
+                            int first = int(plyRead(property.type,q));
+                            for(size_t c = 2; c < nCorners; c++){
+                                item->indices.push_back(first);
+                                item->indices.push_back(int(plyRead(property.type,q+(c-1)*size)));
+                                item->indices.push_back(int(plyRead(property.type,q+c*size)));
+                            }
+                        }
+                        q += nCorners*plySize(property.type);
+                    }
+                    p += recordSize;
+                }
+            }
+        } else {
+            for(size_t i = 0; i < element.count; i++){
+                size_t recordSize = plyRecordSize(element,p,end);
+                if(recordSize == 0){
+                    return meshLoadError(error,"the PLY file is truncated");
+                }
+                p += recordSize;
+            }
+        }
+    }
+    int nVertices = int(item->positions.size());
+    for(int index : item->indices){
+        if(index < 0 || index >= nVertices){
+            return meshLoadError(error,"a PLY face references a vertex which doesnt exist");
+        }
+    }
+    completeItem(item.get(),hasNormals,hasTextCoords);
+    target.push_back(item.release());
+    return true;
+}
+
+bool loadSTLFile(std::string filename, std::vector<objItem*>& target, std::string object_id, std::string* error){
+    MappedFile file;
+    if(!file.open(filename)){
+        return meshLoadError(error,"could not open the file");
+    }
+    const char* data = file.data();
+    size_t size = file.size();
+    uint32_t nTriangles = 0;
+    if(size >= 84){
+        memcpy(&nTriangles,data+80,4);
+    }
+    //ascii files start with "solid" too, but only a binary file has exactly the size its triangle count says
+    if(size < 84 || size != 84 + size_t(nTriangles)*50){
+        return meshLoadError(error,"only binary STL files are supported");
+    }
+
+    //the file is a triangle soup, corners with bit identical positions are welded into one vertex
+    //numbered in the order the positions first appear
+    objItem* item = new objItem();
+    item->name = std::filesystem::path(filename).stem().string();
+    item->filename = filename;
+    item->indices.reserve(size_t(nTriangles)*3);
+    FlatHashTable<uuid128,int,HashKey128> welded = FlatHashTable<uuid128,int,HashKey128>(int(log2(double(nTriangles)+1))+1);
+    //welded facets by their sorted vertices, to drop the duplicated triangles scanner output often has
+    FlatHashTable<uuid128,int,HashKey128> weldedFacets = FlatHashTable<uuid128,int,HashKey128>(int(log2(double(nTriangles)+1))+1);
+    const char* record = data+84;
+    for(size_t t = 0; t < nTriangles; t++, record += 50){
+        cgVec3 corners[3];
+        int inds[3];
+        memcpy(corners,record+12,sizeof(corners)); //after the 12 byte facet normal
+        for(int c = 0; c < 3; c++){
+            float xyz[3] = {corners[c].x+0.0f,corners[c].y+0.0f,corners[c].z+0.0f}; //adding 0 turns -0 into 0
+            uint32_t bits[3];
+            memcpy(bits,xyz,sizeof(bits));
+            uuid128 key;
+            key.dat[0] = uint64_t(bits[0]) | (uint64_t(bits[1]) << 32);
+            key.dat[1] = bits[2];
+            int index = welded.find(key);
+            if(index < 0){
+                index = welded.numElements();
+                welded.add(index,key);
+                item->positions.push_back(corners[c]);
+            }
+            inds[c] = index;
+        }
+        //a triangle welded down to an edge or a point, or one which is already there (either way around), would
+        //only give the simplifier degenerate facets and edges with more than 2 facets
+        if(inds[0] == inds[1] || inds[1] == inds[2] || inds[2] == inds[0]){
+            continue;
+        }
+        int sorted[3] = {inds[0],inds[1],inds[2]};
+        std::sort(sorted,sorted+3);
+        uuid128 facetKey;
+        facetKey.dat[0] = uint64_t(uint32_t(sorted[0])) | (uint64_t(uint32_t(sorted[1])) << 32);
+        facetKey.dat[1] = uint32_t(sorted[2]);
+        if(weldedFacets.find(facetKey) >= 0){
+            continue;
+        }
+        weldedFacets.add(int(t),facetKey);
+        item->indices.insert(item->indices.end(),inds,inds+3);
+    }
+    completeItem(item,false,false);
+    target.push_back(item);
+    return true;
+}
+
+/**
+ * @brief Size and modification time of a file, the cache is only used while both still match
+ *
+ * @param filename
+ * @param size
+ * @param time
+ * @return false if the file doesnt exist
+ */
+static bool fileStamp(const std::string& filename, uint64_t& size, int64_t& time){
+    std::error_code ec;
+    size = std::filesystem::file_size(filename,ec);
+    if(ec){
+        return false;
+    }
+    time = int64_t(std::filesystem::last_write_time(filename,ec).time_since_epoch().count());
+    return !ec;
+}
+
+/**
+ * @brief Lower case extension of filename, with the dot
+ *
+ */
+static std::string fileExtension(const std::string& filename){
+    std::string extension = std::filesystem::path(filename).extension().string();
+    for(char& c : extension){
+        c = char(tolower(c));
+    }
+    return extension;
+}
+
+bool loadMesh(std::string filename, std::vector<objItem*>& target, std::string object_id, bool useCache, int nThreads, std::string* error){
+    std::string extension = fileExtension(filename);
+    if(extension == MESH_CACHE_EXTENSION){
+        if(!loadMeshCache(filename,target)){
+            return meshLoadError(error,"not a valid mesh cache");
+        }
+        return true;
+    }
+
+    uint64_t size = 0;
+    int64_t time = 0;
+    bool stamped = useCache && fileStamp(filename,size,time);
+    std::string cachePath = meshCachePath(filename);
+    if(stamped){
+        MeshCache cache;
+        if(cache.open(cachePath) && cache.sourceSize() == size && cache.sourceTime() == time){
+            cache.load(target);
+            return true;
+        }
+    }
+
+    size_t first = target.size();
+    bool loaded = false;
+    if(extension == ".ply"){
+        loaded = loadPLYFile(filename,target,object_id,nThreads,error);
+    } else if(extension == ".stl"){
+        loaded = loadSTLFile(filename,target,object_id,error);
+    } else {
+        loaded = loadOBJFileMapped(filename,target,object_id,nThreads,error);
+    }
+    if(!loaded){
+        return false;
+    }
+    if(stamped){
+        std::vector<objItem*> items = std::vector<objItem*>(target.begin()+first,target.end());
+        writeMeshCache(cachePath,items,size,time); //a cache which cant be written (read only directory) just isnt used
+    }
+    return true;
+}
@@ -0,0 +1,169 @@
+#include "MeshWriter.hpp"
+#include "Parallel.hpp"
+#include <stdio.h>
+#include <string.h>
+#include <charconv>
+
+static const size_t linesPerBlock = 1 << 13;
+static const size_t maxLineLength = 96; //"f a//a b//b c//c" with 10 digit indices, a v line is shorter
+
+enum OBJLineType{
+    OBJ_LINE_V,
+    OBJ_LINE_VN,
+    OBJ_LINE_F
+};
+
+//a range of the v, vn or f lines of one object, formatted as a unit
+struct OBJBlock{
+    int item;
+    OBJLineType type;
+    size_t begin;
+    size_t end;
+};
+
+static inline char* writeFloat(char* p, float value){
+    return std::to_chars(p,p+32,value).ptr;
+}
+
+static inline char* writeIndex(char* p, size_t value){
+    return std::to_chars(p,p+24,value).ptr;
+}
+
+/**
+ * @brief Name written on the "o" line of an object. Obj readers take the first word after the "o", so blanks
+ * become underscores and an object without a name gets objectN (N 1 based), a bare "o" would make readers
+ * merge it into the previous object or take the next line as its name
+ *
+ * @param name
+ * @param index
+ * @return std::string
+ */
+static std::string objectName(const std::string& name, size_t index){
+    if(name.empty()){
+        return "object" + std::to_string(index+1);
+    }
+    std::string result = name;
+    for(char& c : result){
+        if(c == ' ' || c == '\t' || c == '\r' || c == '\n'){
+            c = '_';
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Formats the lines of block into buffer, which must hold maxLineLength per line plus the "o" line
+ *
+ * @param item
+ * @param name written on the "o" line, see objectName
+ * @param block
+ * @param base index in the file of the first point of the object (1 based)
+ * @param buffer
+ * @return size_t number of bytes written
+ */
+static size_t formatBlock(OBJWriteItem& item, const std::string& name, const OBJBlock& block, size_t base, char* buffer){
+    char* p = buffer;
+    if(block.type == OBJ_LINE_V && block.begin == 0){
+        *p++ = 'o';
+        *p++ = ' ';
+        memcpy(p,name.data(),name.size());
+        p += name.size();
+        *p++ = '\n';
+    }
+    if(block.type == OBJ_LINE_F){
+        bool withNormals = item.normals != nullptr;
+        std::vector<geo::Facet>& facets = *item.facets;
+        for(size_t i = block.begin; i < block.end; i++){
+            *p++ = 'f';
+            for(int k = 0; k < 3; k++){
+                *p++ = ' ';
+                size_t index = base + size_t(facets[i].inds[k]);
+                p = writeIndex(p,index);
+                if(withNormals){
+                    *p++ = '/';
+                    *p++ = '/';
+                    p = writeIndex(p,index);
+                }
+            }
+            *p++ = '\n';
+        }
+    } else {
+        bool isNormal = block.type == OBJ_LINE_VN;
+        std::vector<cgVec3>& vectors = isNormal ? *item.normals : *item.points;
+        for(size_t i = block.begin; i < block.end; i++){
+            const cgVec3& v = vectors[i];
+            *p++ = 'v';
+            if(isNormal){
+                *p++ = 'n';
+            }
+            *p++ = ' ';
+            p = writeFloat(p,v.x);
+            *p++ = ' ';
+            p = writeFloat(p,v.y);
+            *p++ = ' ';
+            p = writeFloat(p,v.z);
+            *p++ = '\n';
+        }
+    }
+    return size_t(p-buffer);
+}
+
+/**
+ * @brief Splits n lines of one object into blocks of at most linesPerBlock lines
+ *
+ */
+static void addBlocks(int item, OBJLineType type, size_t n, std::vector<OBJBlock>& blocks){
+    for(size_t begin = 0; begin < n; begin += linesPerBlock){
+        blocks.push_back({item,type,begin,std::min(n,begin+linesPerBlock)});
+    }
+}
+
+bool writeOBJFile(const std::string& filename, std::vector<OBJWriteItem>& items, int nThreads){
+    nThreads = par::numThreads(nThreads);
+    std::vector<OBJBlock> blocks;
+    std::vector<size_t> bases = std::vector<size_t>(items.size());
+    std::vector<std::string> names = std::vector<std::string>(items.size());
+    size_t base = 1; //obj indices are 1 based and global to the file
+    for(size_t m = 0; m < items.size(); m++){
+        OBJWriteItem& item = items[m];
+        bases[m] = base;
+        names[m] = objectName(item.name,m);
+        size_t nPoints = item.points->size();
+        addBlocks(int(m),OBJ_LINE_V,nPoints,blocks);
+        if(nPoints == 0){
+            blocks.push_back({int(m),OBJ_LINE_V,0,0}); //the first v block carries the "o" line
+        }
+        if(item.normals){
+            addBlocks(int(m),OBJ_LINE_VN,item.normals->size(),blocks);
+        }
+        addBlocks(int(m),OBJ_LINE_F,item.facets->size(),blocks);
+        base += nPoints;
+    }
+
+    FILE* out = fopen(filename.c_str(),"wb");
+    if(!out){
+        return false;
+    }
+    //blocks are formatted a round at a time so the buffers stay bounded however large the mesh is
+    int nSlots = nThreads*2;
+    std::vector<std::vector<char>> buffers = std::vector<std::vector<char>>(nSlots);
+    std::vector<size_t> lengths = std::vector<size_t>(nSlots);
+    for(size_t first = 0; first < blocks.size(); first += size_t(nSlots)){
+        int nRound = int(std::min(blocks.size()-first,size_t(nSlots)));
+        par::parallelFor(nRound,nThreads,[&](int slot, int thread){
+            const OBJBlock& block = blocks[first+slot];
+            OBJWriteItem& item = items[block.item];
+            const std::string& name = names[block.item];
+            size_t capacity = (block.end-block.begin)*maxLineLength + name.size() + 4;
+            if(buffers[slot].size() < capacity){
+                buffers[slot].resize(capacity);
+            }
+            lengths[slot] = formatBlock(item,name,block,bases[block.item],buffers[slot].data());
+        },1);
+        for(int slot = 0; slot < nRound; slot++){
+            fwrite(buffers[slot].data(),1,lengths[slot],out);
+        }
+    }
+    bool ok = !ferror(out);
+    return fclose(out) == 0 && ok;
+}
@@ -121,20 +121,6 @@ cgMat4 lookAt(cgVec3 eye, cgVec3 center, cgVec3 up)
     return result;
 }
 
-cgVec3 cross(const cgVec3 &v1, const cgVec3 &v2)
-{
-    cgVec3 out = cgVec3();
-    out.x = v1.y * v2.z - v1.z * v2.y;
-    out.y = v1.z * v2.x - v1.x * v2.z;
-    out.z = v1.x * v2.y - v1.y * v2.x;
-    return out;
-}
-
-float dot(cgVec3 v1, cgVec3 v2)
-{
-    return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z;
-}
-
 cgMat4 cgMat4::operator*(const cgMat4 &mat) const
 {
     cgMat4 output = cgMat4();
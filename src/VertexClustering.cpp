@@ -0,0 +1,414 @@
+#include "VertexClustering.hpp"
+#include "Parallel.hpp"
+#include <math.h>
+#include <limits>
+
+static const int maxSplitDepth = 3; //a broken cell is halved this many times before it falls apart into single vertices
+
+/**
+ * @brief Vertex to facet adjacency of a facet list in compressed rows,
+ * the facets touching vertex v are facetIds[begin[v]] to facetIds[begin[v+1]-1]
+ *
+ */
+struct VertexFacets{
+    std::vector<int> begin;
+    std::vector<int> facetIds;
+
+    void build(std::vector<geo::Facet>& facets, int nPts){
+        begin = std::vector<int>(nPts+1,0);
+        for(geo::Facet& f : facets){
+            for(int k = 0; k < 3; k++){
+                begin[f.inds[k]+1]++;
+            }
+        }
+        for(int v = 0; v < nPts; v++){
+            begin[v+1] += begin[v];
+        }
+        facetIds = std::vector<int>(begin[nPts]);
+        std::vector<int> fill = std::vector<int>(begin.begin(),begin.end()-1);
+        for(int i = 0; i < int(facets.size()); i++){
+            for(int k = 0; k < 3; k++){
+                facetIds[fill[facets[i].inds[k]]++] = i;
+            }
+        }
+    }
+};
+
+/**
+ * @brief Per thread buffers for checkVertex
+ *
+ */
+struct LinkScratch{
+    std::vector<int> neighbor; //neighbors of the vertex with the number of edges leaving and entering it
+    std::vector<int> nOut;
+    std::vector<int> nIn;
+    std::vector<int> parent; //union find over the neighbors, joined by the link edges
+};
+
+static int linkIndex(LinkScratch& s, int v){
+    for(int i = 0; i < int(s.neighbor.size()); i++){
+        if(s.neighbor[i] == v){
+            return i;
+        }
+    }
+    s.neighbor.push_back(v);
+    s.nOut.push_back(0);
+    s.nIn.push_back(0);
+    s.parent.push_back(int(s.neighbor.size())-1);
+    return int(s.neighbor.size())-1;
+}
+
+static int linkRoot(LinkScratch& s, int i){
+    while(s.parent[i] != i){
+        s.parent[i] = s.parent[s.parent[i]];
+        i = s.parent[i];
+    }
+    return i;
+}
+
+/**
+ * @brief Checks the one-ring of v: every edge has at most one facet on each side, and the facets
+ * form a single fan (the link of the vertex is one path or one loop). Sets isHorizon if an edge of
+ * v has only one facet. Returns false if the vertex is non-manifold.
+ *
+ * @param facets
+ * @param adjacency
+ * @param v
+ * @param s
+ * @param isHorizon
+ * @return true
+ * @return false
+ */
+static bool checkVertex(std::vector<geo::Facet>& facets, VertexFacets& adjacency, int v, LinkScratch& s, bool& isHorizon){
+    s.neighbor.clear();
+    s.nOut.clear();
+    s.nIn.clear();
+    s.parent.clear();
+    isHorizon = false;
+    int nLinkEdges = adjacency.begin[v+1]-adjacency.begin[v];
+    if(nLinkEdges == 0){
+        return true;
+    }
+    for(int i = adjacency.begin[v]; i < adjacency.begin[v+1]; i++){
+        geo::Facet& f = facets[adjacency.facetIds[i]];
+        int k = f.inds[0] == v ? 0 : (f.inds[1] == v ? 1 : 2);
+        int next = linkIndex(s,f.inds[(k+1)%3]);
+        int prev = linkIndex(s,f.inds[(k+2)%3]);
+        s.nOut[next]++; //edge v->next
+        s.nIn[prev]++; //edge prev->v
+        int a = linkRoot(s,next);
+        int b = linkRoot(s,prev);
+        if(a != b){
+            s.parent[a] = b;
+        }
+    }
+    int nRoots = 0;
+    for(int i = 0; i < int(s.neighbor.size()); i++){
+        if(s.nOut[i] > 1 || s.nIn[i] > 1){
+            return false; //more than one facet on the same side of an edge
+        }
+        isHorizon = isHorizon || s.nOut[i]+s.nIn[i] == 1;
+        nRoots += int(linkRoot(s,i) == i);
+    }
+    return nRoots == 1;
+}
+
+/**
+ * @brief Returns the vertex in members[begin,end) closest to their mean
+ *
+ * @param points
+ * @param members
+ * @param begin
+ * @param end
+ * @return int
+ */
+static int closestToMean(std::vector<cgVec3>& points, std::vector<int>& members, int begin, int end){
+    double sum[3] = {0,0,0};
+    for(int i = begin; i < end; i++){
+        cgVec3& p = points[members[i]];
+        sum[0] += p.x;
+        sum[1] += p.y;
+        sum[2] += p.z;
+    }
+    double n = double(end-begin);
+    cgVec3 mean = cgVec3(float(sum[0]/n),float(sum[1]/n),float(sum[2]/n));
+    int best = members[begin];
+    float bestDist = std::numeric_limits<float>::max();
+    for(int i = begin; i < end; i++){
+        float d = (points[members[i]]-mean).norm();
+        if(d < bestDist){
+            best = members[i];
+            bestDist = d;
+        }
+    }
+    return best;
+}
+
+static int findRoot(std::vector<int>& parent, int v){
+    while(parent[v] != v){
+        parent[v] = parent[parent[v]];
+        v = parent[v];
+    }
+    return v;
+}
+
+static cgVec3 facetNormal(std::vector<cgVec3>& points, int i0, int i1, int i2){
+    return cross(points[i1]-points[i0],points[i2]-points[i0]);
+}
+
+void AutoLOD::clusterVertices(std::vector<geo::Facet>& meshFacets, std::vector<cgVec3>& meshPoints, int targetSize, int nThreads,
+                              std::vector<geo::Facet>& target, std::vector<int>& targetIds){
+    int nPts = int(meshPoints.size());
+    int nFacets = int(meshFacets.size());
+    nThreads = par::numThreads(nThreads);
+    std::vector<LinkScratch> scratch = std::vector<LinkScratch>(nThreads);
+
+    //horizon vertices stay where they are
+    VertexFacets adjacency;
+    adjacency.build(meshFacets,nPts);
+    std::vector<uint8_t> locked = std::vector<uint8_t>(nPts,0);
+    par::parallelFor(nPts,nThreads,[&](int v, int thread){
+        bool isHorizon;
+        checkVertex(meshFacets,adjacency,v,scratch[thread],isHorizon);
+        locked[v] = uint8_t(isHorizon);
+    });
+
+    std::vector<int> freeVerts; //vertices which may be merged
+    int nLocked = 0;
+    float lo[3] = {std::numeric_limits<float>::max(),std::numeric_limits<float>::max(),std::numeric_limits<float>::max()};
+    float hi[3] = {-std::numeric_limits<float>::max(),-std::numeric_limits<float>::max(),-std::numeric_limits<float>::max()};
+    for(int v = 0; v < nPts; v++){
+        if(adjacency.begin[v+1] == adjacency.begin[v]){
+            continue;
+        }
+        if(locked[v]){
+            nLocked++;
+            continue;
+        }
+        freeVerts.push_back(v);
+        for(int a = 0; a < 3; a++){
+            lo[a] = std::min(lo[a],meshPoints[v].at(a));
+            hi[a] = std::max(hi[a],meshPoints[v].at(a));
+        }
+    }
+    int nFree = int(freeVerts.size());
+    int freeTarget = std::max(1,targetSize-nLocked);
+    bool isFlat = nFree == 0 || (hi[0] <= lo[0] && hi[1] <= lo[1] && hi[2] <= lo[2]);
+    if(nFree <= freeTarget || isFlat){
+        target.insert(target.end(),meshFacets.begin(),meshFacets.end());
+        for(int i = 0; i < nFacets; i++){
+            targetIds.push_back(i);
+        }
+        return;
+    }
+
+    //a surface of area A crosses about A/cellSize^2 cells, start there and correct with the actual cell count
+    std::vector<float> facetArea = std::vector<float>(nFacets);
+    par::parallelFor(nFacets,nThreads,[&](int i, int thread){
+        geo::Facet& f = meshFacets[i];
+        facetArea[i] = 0.5f*facetNormal(meshPoints,f.inds[0],f.inds[1],f.inds[2]).norm();
+    });
+    double area = 0;
+    for(float a : facetArea){
+        area += a; //summed in order so the grid doesnt depend on the thread count
+    }
+    double extent = std::max(double(hi[0]-lo[0]),std::max(double(hi[1]-lo[1]),double(hi[2]-lo[2])));
+    double minCellSize = extent/double(1 << 20); //keeps the cell coordinates within the 21 bits of the key
+    double cellSize = std::max(sqrt(area/double(freeTarget)),minCellSize);
+
+    std::vector<uint64_t> cellKey = std::vector<uint64_t>(nPts,0);
+    std::vector<int> cluster = std::vector<int>(nPts,-1);
+    std::vector<int> parent = std::vector<int>(nPts);
+    int nClusters = 0;
+    for(int iteration = 0; ; iteration++){
+        par::parallelFor(nFree,nThreads,[&](int i, int thread){
+            cgVec3& p = meshPoints[freeVerts[i]];
+            uint64_t ix = uint64_t((p.x-lo[0])/cellSize);
+            uint64_t iy = uint64_t((p.y-lo[1])/cellSize);
+            uint64_t iz = uint64_t((p.z-lo[2])/cellSize);
+            cellKey[freeVerts[i]] = (ix << 42) | (iy << 21) | iz;
+        });
+
+        //a cluster is a connected piece of the surface inside a cell, separate sheets passing through the same cell stay apart
+        for(int v : freeVerts){
+            parent[v] = v;
+        }
+        for(geo::Facet& f : meshFacets){
+            for(int k = 0; k < 3; k++){
+                int a = f.inds[k];
+                int b = f.inds[(k+1)%3];
+                if(locked[a] || locked[b] || cellKey[a] != cellKey[b]){
+                    continue;
+                }
+                a = findRoot(parent,a);
+                b = findRoot(parent,b);
+                if(a != b){
+                    parent[std::max(a,b)] = std::min(a,b);
+                }
+            }
+        }
+        //numbered in vertex order so the result doesnt depend on the thread count
+        nClusters = 0;
+        for(int v : freeVerts){
+            int root = findRoot(parent,v);
+            cluster[v] = root == v ? nClusters++ : cluster[root];
+        }
+        double ratio = double(nClusters)/double(freeTarget);
+        if((ratio > 0.9 && ratio < 1.1) || iteration == 3){
+            break; //cellSize stays the one the clusters came from, splitCluster halves the same cells
+        }
+        cellSize = std::max(cellSize*sqrt(ratio),minCellSize);
+    }
+
+    //members of each cell stored contiguously in vertex order, a cluster is a range of members
+    std::vector<int> members = std::vector<int>(nFree);
+    std::vector<int> clusterBegin = std::vector<int>(nClusters+1,0);
+    for(int v : freeVerts){
+        clusterBegin[cluster[v]+1]++;
+    }
+    for(int c = 0; c < nClusters; c++){
+        clusterBegin[c+1] += clusterBegin[c];
+    }
+    std::vector<int> clusterEnd = std::vector<int>(clusterBegin.begin()+1,clusterBegin.end());
+    clusterBegin.pop_back();
+    std::vector<int> fill = clusterBegin;
+    for(int v : freeVerts){
+        members[fill[cluster[v]]++] = v;
+    }
+    std::vector<int> depth = std::vector<int>(nClusters,0); //number of times the cell was halved
+    std::vector<int> born = std::vector<int>(nClusters,-1); //round in which the cluster was split off
+    std::vector<int> rep = std::vector<int>(nClusters);
+    par::parallelFor(nClusters,nThreads,[&](int c, int thread){
+        rep[c] = closestToMean(meshPoints,members,clusterBegin[c],clusterEnd[c]);
+    });
+
+    auto addCluster = [&](int begin, int end, int d, int round){
+        int c = int(rep.size());
+        clusterBegin.push_back(begin);
+        clusterEnd.push_back(end);
+        depth.push_back(d);
+        born.push_back(round);
+        rep.push_back(closestToMean(meshPoints,members,begin,end));
+        for(int i = begin; i < end; i++){
+            cluster[members[i]] = c;
+        }
+    };
+
+    //a broken cluster is replaced by the clusters of its 8 octants, after a few levels by its single vertices
+    std::vector<int> octantMembers;
+    auto splitCluster = [&](int v, int round, bool& changed){
+        int c = cluster[v];
+        if(c < 0 || born[c] == round || clusterEnd[c]-clusterBegin[c] <= 1){
+            return;
+        }
+        changed = true;
+        int begin = clusterBegin[c];
+        int end = clusterEnd[c];
+        if(depth[c] >= maxSplitDepth){
+            for(int i = begin; i < end; i++){
+                addCluster(i,i+1,depth[c]+1,round);
+            }
+            return;
+        }
+        double subSize = cellSize/double(2 << depth[c]);
+        int count[8] = {0,0,0,0,0,0,0,0};
+        octantMembers.clear();
+        for(int i = begin; i < end; i++){
+            cgVec3& p = meshPoints[members[i]];
+            int octant = int(int64_t((p.x-lo[0])/subSize) & 1) | int(int64_t((p.y-lo[1])/subSize) & 1) << 1 | int(int64_t((p.z-lo[2])/subSize) & 1) << 2;
+            octantMembers.push_back(octant);
+            count[octant]++;
+        }
+        int start[8];
+        int offset = begin;
+        for(int o = 0; o < 8; o++){
+            start[o] = offset;
+            offset += count[o];
+        }
+        std::vector<int> sorted = std::vector<int>(end-begin);
+        int next[8];
+        std::copy(start,start+8,next);
+        for(int i = begin; i < end; i++){
+            sorted[next[octantMembers[i-begin]]++ - begin] = members[i];
+        }
+        std::copy(sorted.begin(),sorted.end(),members.begin()+begin);
+        for(int o = 0; o < 8; o++){
+            if(count[o] > 0){
+                addCluster(start[o],start[o]+count[o],depth[c]+1,round);
+            }
+        }
+    };
+    auto mapVertex = [&](int v){
+        int c = cluster[v];
+        return c < 0 ? v : rep[c];
+    };
+
+    //merge, then split the clusters around anything the merge broke until nothing is broken
+    std::vector<geo::Facet> merged;
+    std::vector<int> mergedIds;
+    std::vector<uint8_t> badFacet;
+    std::vector<uint8_t> badVertex = std::vector<uint8_t>(nPts,0);
+    for(int round = 0; ; round++){
+        merged.clear();
+        mergedIds.clear();
+        for(int i = 0; i < nFacets; i++){
+            geo::Facet& f = meshFacets[i];
+            geo::Facet m = geo::Facet(mapVertex(f.inds[0]),mapVertex(f.inds[1]),mapVertex(f.inds[2]));
+            if(m.inds[0] == m.inds[1] || m.inds[1] == m.inds[2] || m.inds[2] == m.inds[0]){
+                continue; //collapsed inside a cell
+            }
+            merged.push_back(m);
+            mergedIds.push_back(i);
+        }
+
+        badFacet = std::vector<uint8_t>(merged.size(),0);
+        par::parallelFor(int(merged.size()),nThreads,[&](int i, int thread){
+            geo::Facet& f = meshFacets[mergedIds[i]];
+            geo::Facet& m = merged[i];
+            cgVec3 n0 = facetNormal(meshPoints,f.inds[0],f.inds[1],f.inds[2]);
+            cgVec3 n1 = facetNormal(meshPoints,m.inds[0],m.inds[1],m.inds[2]);
+            badFacet[i] = uint8_t(dot(n0,n1) <= 0); //flipped or zero area
+        });
+
+        adjacency.build(merged,nPts);
+        par::parallelFor(nPts,nThreads,[&](int v, int thread){
+            bool isHorizon;
+            bool isManifold = checkVertex(merged,adjacency,v,scratch[thread],isHorizon);
+            //a merge which opens a hole in a closed part of the surface is broken as well
+            badVertex[v] = uint8_t(!isManifold || (isHorizon && !locked[v]));
+        });
+
+        bool changed = false;
+        for(int i = 0; i < int(merged.size()); i++){
+            if(badFacet[i]){
+                for(int k = 0; k < 3; k++){
+                    splitCluster(merged[i].inds[k],round,changed);
+                }
+            }
+        }
+        for(int v = 0; v < nPts; v++){
+            if(!badVertex[v]){
+                continue;
+            }
+            bool splitOwn = false;
+            splitCluster(v,round,splitOwn);
+            changed = changed || splitOwn;
+            if(splitOwn || (cluster[v] >= 0 && born[cluster[v]] == round)){
+                continue;
+            }
+            //the vertex wasnt merged with anything, its neighbors were
+            for(int i = adjacency.begin[v]; i < adjacency.begin[v+1]; i++){
+                geo::Facet& m = merged[adjacency.facetIds[i]];
+                for(int k = 0; k < 3; k++){
+                    splitCluster(m.inds[k],round,changed);
+                }
+            }
+        }
+        if(!changed){
+            break; //whatever is left was already broken in the input
+        }
+    }
+
+    target.insert(target.end(),merged.begin(),merged.end());
+    targetIds.insert(targetIds.end(),mergedIds.begin(),mergedIds.end());
+}